@@ -22,14 +22,13 @@ typedef int fixed;
 #define fixed_div(a, b) (((a) << 4) / (b))
 #define fixed_mul(a, b) (((a) * (b)) >> 4)
 
+// Integer division rounded to the nearest, b > 0
+#define div_round(a, b) ((a) >= 0 ? ((a) + (b) / 2) / (b) : ((a) - (b) / 2) / (b))
+
 //#define interpol_color_(c1, c2) c1 = (int16_t)(c1 * 0x55 + ((int16_t)(c2) * 0x55 - (int16_t)(c1) * 0x55) * br) >> 6;
 #define interpol_color_(c1, c2) c1 = ((c1) * fixed_1 + ((c2) - (c1)) * br + fixed_05) >> 4
-inline void _plot(uint8_t* pixels, int16_t w, int16_t h, int16_t x, int16_t y, GColor8 color, fixed br)
+static inline void blend_pixel_(GColor8* oc, GColor8 color, fixed br)
 {
-	if(x<0 || x>(w-1) || y<0 || y>(h-1))
-		return;
-
-	GColor8* oc = (GColor8*)(pixels + x + w * y);
 	if( br >= fixed_1 ) {
       memcpy(oc, &color, sizeof(GColor8));
 	}
@@ -40,6 +39,24 @@ inline void _plot(uint8_t* pixels, int16_t w, int16_t h, int16_t x, int16_t y, G
 	}
 }
 
+// Covers br1 of the pixel with color1 and br2 with color2, br1 + br2 <= fixed_1, in a single write
+#define interpol_color_pair_(c0, c1, c2) c0 = ((c0) * (fixed_1 - br1 - br2) + (c1) * br1 + (c2) * br2 + fixed_05) >> 4
+static inline void blend_pixel_pair_(GColor8* oc, GColor8 color1, fixed br1, GColor8 color2, fixed br2)
+{
+	interpol_color_pair_(oc->r, color1.r, color2.r);
+	interpol_color_pair_(oc->g, color1.g, color2.g);
+	interpol_color_pair_(oc->b, color1.b, color2.b);
+}
+
+// The bitmap may be a sub bitmap : its bounds clip the drawing and its rows are stride bytes long
+static inline void _plot(uint8_t* pixels, uint16_t stride, const GRect* clip, int16_t x, int16_t y, GColor8 color, fixed br)
+{
+	if(x<clip->origin.x || x>=clip->origin.x+clip->size.w || y<clip->origin.y || y>=clip->origin.y+clip->size.h)
+		return;
+
+	blend_pixel_((GColor8*)(pixels + x + stride * y), color, br);
+}
+
 #define ipart_(X) ((X) >> 4)
 #define fpart_(X) ((X) & 0xf)
 #define rfpart_(X) (fixed_1 - fpart_(X))
@@ -48,8 +65,8 @@ inline void _plot(uint8_t* pixels, int16_t w, int16_t h, int16_t x, int16_t y, G
 void draw_line_antialias_(GBitmap* img, int16_t x1, int16_t y1, int16_t x2, int16_t y2, GColor8 color)
 {
 	uint8_t* img_pixels = gbitmap_get_data(img);
-	int16_t  w 	= gbitmap_get_bounds(img).size.w;
-	int16_t  h 	= gbitmap_get_bounds(img).size.h;
+	uint16_t stride	= gbitmap_get_bytes_per_row(img);
+	GRect    clip 	= gbitmap_get_bounds(img);
 
 	fixed dx = int_to_fixed(abs(x1 - x2));
 	fixed dy = int_to_fixed(abs(y1 - y2));
@@ -68,23 +85,42 @@ void draw_line_antialias_(GBitmap* img, int16_t x1, int16_t y1, int16_t x2, int1
 	dx = x2 - x1;
 	dy = y2 - y1;
 
+	// Single point, nothing to interpolate
+	if(dx == 0){
+		_plot(img_pixels, stride, &clip, x1, y1, color, fixed_1);
+		return;
+	}
+
     fixed intery;
 	int x;
 	for(x=x1; x <= x2; x++) {
         intery = int_to_fixed(y1) + (int_to_fixed(x - x1) * dy / dx);
 		if(x>=0){
 			if(steep){
-				_plot(img_pixels, w, h, ipart_(intery)    , x, color, rfpart_(intery));
-				_plot(img_pixels, w, h, ipart_(intery) + 1, x, color,  fpart_(intery));
+				_plot(img_pixels, stride, &clip, ipart_(intery)    , x, color, rfpart_(intery));
+				_plot(img_pixels, stride, &clip, ipart_(intery) + 1, x, color,  fpart_(intery));
 			}
 			else {
-				_plot(img_pixels, w, h, x, ipart_(intery)	 , color, rfpart_(intery));
-				_plot(img_pixels, w, h, x, ipart_(intery) + 1, color,  fpart_(intery));
+				_plot(img_pixels, stride, &clip, x, ipart_(intery)	 , color, rfpart_(intery));
+				_plot(img_pixels, stride, &clip, x, ipart_(intery) + 1, color,  fpart_(intery));
 			}
 		}
 	}
 }
 
+// Draws the outline made of the given points, translated by offset, in the bitmap
+static void draw_points_outline_(GBitmap* bitmap, const GPoint* points, uint32_t num_points, bool closed, GPoint offset, GColor8 color){
+	if(num_points == 0)
+		return;
+
+	GPoint p1 = points[closed ? num_points - 1 : 0];
+	for(uint32_t i=(closed ? 0 : 1); i<num_points; i++){
+		GPoint p2 = points[i];
+		draw_line_antialias_(bitmap, p1.x + offset.x, p1.y + offset.y, p2.x + offset.x, p2.y + offset.y, color);
+		p1 = p2;
+	}
+}
+
 void graphics_draw_line_antialiased(GContext* ctx, GPoint p0, GPoint p1, GColor8 stroke_color){
 	if(p0.x == p1.x || p0.y == p1.y || p0.x-p1.x == p0.y-p1.y || p0.x-p1.x == p1.y-p0.y){
 		graphics_draw_line(ctx, p0, p1);
@@ -96,13 +132,12 @@ void graphics_draw_line_antialiased(GContext* ctx, GPoint p0, GPoint p1, GColor8
 	}
 }
 
-void gpath_draw_outline_antialiased(GContext* ctx, GPath *path, GColor8 stroke_color){
+static void draw_path_outline_(GBitmap* bitmap, GPath *path, GColor8 stroke_color){
 	if(path->num_points == 0)
 		return;	
 
 	GPoint offset = path->offset;
 	int32_t rotation = path->rotation;
-	GBitmap* bitmap = graphics_capture_frame_buffer(ctx);
 
   	int32_t s = sin_lookup(rotation);
   	int32_t c = cos_lookup(rotation);
@@ -119,464 +154,1793 @@ void gpath_draw_outline_antialiased(GContext* ctx, GPath *path, GColor8 stroke_c
 		draw_line_antialias_(bitmap, p1.x, p1.y, p2.x, p2.y, stroke_color);
 		p1 = p2;
 	}
+}
 
+void gpath_draw_outline_antialiased(GContext* ctx, GPath *path, GColor8 stroke_color){
+	GBitmap* bitmap = graphics_capture_frame_buffer(ctx);
+	draw_path_outline_(bitmap, path, stroke_color);
 	graphics_release_frame_buffer(ctx, bitmap);
 }
 
-#define set_pixel_(pixels, bytes_per_row, x, y) (pixels[(y) * (bytes_per_row) + (x) / 8] |= (1<<((x)%8)))
-#define get_pixel_(pixels, bytes_per_row, x, y) (pixels[(y) * (bytes_per_row) + (x) / 8]  & (1<<((x)%8)))
+static void draw_circle_(GBitmap* bitmap, GPoint center, uint16_t radius, GColor8 stroke_color){
+	uint8_t sections = 9; //TODO tweak that
+	GPoint prev_p = (GPoint){0,0};
+	GPoint p;
+	for (uint8_t i = 0; i < sections; i++)
+	{
+  		int32_t angle = i * TRIG_MAX_ANGLE / (4 *  (sections - 1) );
+  		int32_t s = sin_lookup(angle);
+  		int32_t c = cos_lookup(angle);
+
+  		p.x = -radius * s / TRIG_MAX_RATIO;
+  		p.y =  radius * c / TRIG_MAX_RATIO;
+
+  		// p is the point in the top right quarter (between 0 and 90°)
+  		// by symmmetry we draw the other quarters
+  		if(i>0){
+  			draw_line_antialias_(bitmap, center.x + prev_p.x, center.y + prev_p.y, center.x + p.x, center.y + p.y, stroke_color);
+  			draw_line_antialias_(bitmap, center.x - prev_p.x, center.y + prev_p.y, center.x - p.x, center.y + p.y, stroke_color);
+  			draw_line_antialias_(bitmap, center.x + prev_p.x, center.y - prev_p.y, center.x + p.x, center.y - p.y, stroke_color);
+  			draw_line_antialias_(bitmap, center.x - prev_p.x, center.y - prev_p.y, center.x - p.x, center.y - p.y, stroke_color);
+  		}
+
+  		prev_p = p;
+	}
+}
+
+void graphics_draw_circle_antialiased(GContext* ctx, GPoint center, uint16_t radius, GColor8 stroke_color){
+	GBitmap* bitmap = graphics_capture_frame_buffer(ctx);
+	draw_circle_(bitmap, center, radius, stroke_color);
+	graphics_release_frame_buffer(ctx, bitmap);
+}
 
 /**
   * From https://github.com/Jnmattern/Minimalist_2.0/blob/master/src/bitmap.h
   */
-static void bmpDrawLine(uint8_t *pixels, int bytes_per_row, int x1, int y1, int x2, int y2) {
-	int dx, dy, e;
+static void bmpHLine(uint8_t* img_pixels, uint16_t stride, const GRect* clip, int x1, int x2, int y, GColor8 c) {
+	if (y < clip->origin.y || y >= clip->origin.y + clip->size.h) return;
+	if (x1 < clip->origin.x) x1 = clip->origin.x;
+	if (x2 > clip->origin.x + clip->size.w - 1) x2 = clip->origin.x + clip->size.w - 1;
+	if (x1 <= x2) memset(img_pixels + x1 + stride*y, c.argb, x2 - x1 + 1);
+}
+
+static void bmpFillCircle(GBitmap *bmp, GPoint center, int r, GColor8 c) {
+	int x = 0, y = r, d = r-1;
+
+	uint8_t* img_pixels = gbitmap_get_data(bmp);
+	uint16_t stride	= gbitmap_get_bytes_per_row(bmp);
+	GRect    clip 	= gbitmap_get_bounds(bmp);
     
-	if ((dx = x2-x1) != 0) {
-		if (dx > 0) {
-			if ((dy = y2-y1) != 0) {
-				if (dy > 0) {
-					// vecteur oblique dans le 1er quadran
-					if (dx >= dy) {
-						// vecteur diagonal ou oblique proche de l’horizontale, dans le 1er octant
-						e = dx;
-						dx = 2*e;
-						dy = 2*dy;
-						while (1) {
-							set_pixel_(pixels, bytes_per_row, x1, y1);
-							x1++;
-							if (x1 == x2) break;
-							e -= dy;
-							if (e < 0) {
-								y1++;
-								e += dx;
-							}
-						}
-					} else {
-						// vecteur oblique proche de la verticale, dans le 2nd octant
-						e = dy;
-						dy = 2*e;
-						dx = 2*dx;
-						while (1) {
-							set_pixel_(pixels, bytes_per_row, x1, y1);
-							y1++;
-							if (y1 == y2) break;
-							e -= dx;
-							if (e < 0) {
-								x1++;
-								e += dy;
-							}
-						}
-					}
-				} else { // dy < 0 (et dx > 0)
-					// vecteur oblique dans le 4e cadran
-					if (dx >= -dy) {
-						// vecteur diagonal ou oblique proche de l’horizontale, dans le 8e octant
-						e = dx;
-						dx = 2*e;
-						dy = 2*dy;
-						while (1) {
-							set_pixel_(pixels, bytes_per_row, x1, y1);
-							x1++;
-							if (x1 == x2) break;
-							e += dy;
-							if (e < 0) {
-								y1--;
-								e += dx;
-							}
-						}
-					} else {
-						// vecteur oblique proche de la verticale, dans le 7e octant
-						e = dy;
-						dy = 2*e;
-						dx = 2*dx;
-						while (1) {
-							set_pixel_(pixels, bytes_per_row, x1, y1);
-							y1--;
-							if (y1 == y2) break;
-							e += dx;
-							if (e > 0) {
-								x1++;
-								e += dy;
-							}
-						}
-					}
-				}
-			} else {
-				// dy = 0 (et dx > 0)
-                // vecteur horizontal vers la droite
-				while (1) {
-					set_pixel_(pixels, bytes_per_row, x1, y1);
-					x1++;
-					if (x1 == x2) break;
-				}
-			}
+	while (y >= x) {
+        bmpHLine(img_pixels, stride, &clip, center.x-x, center.x+x, center.y+y, c);
+        bmpHLine(img_pixels, stride, &clip, center.x-y, center.x+y, center.y+x, c);
+        bmpHLine(img_pixels, stride, &clip, center.x-x, center.x+x, center.y-y, c);
+        bmpHLine(img_pixels, stride, &clip, center.x-y, center.x+y, center.y-x, c);
+        
+		if (d >= 2*x-2) {
+			d = d-2*x;
+			x++;
+		} else if (d <= 2*r - 2*y) {
+			d = d+2*y-1;
+			y--;
 		} else {
-			// dx < 0
-			if ((dy = y2-y1) != 0) {
-				if (dy > 0) {
-					// vecteur oblique dans le 2nd quadran
-					if (-dx >= dy) {
-						// vecteur diagonal ou oblique proche de l’horizontale, dans le 4e octant
-						e = dx;
-						dx = 2*e;
-						dy = 2*dy;
-						while (1) {
-							set_pixel_(pixels, bytes_per_row, x1, y1);
-							x1--;
-							if (x1 == x2) break;
-							e += dy;
-							if (e >= 0) {
-								y1++;
-								e += dx;
-							}
-						}
-					} else {
-						// vecteur oblique proche de la verticale, dans le 3e octant
-						e = dy;
-						dy = 2*e;
-						dx = 2*dx;
-						while (1) {
-							set_pixel_(pixels, bytes_per_row, x1, y1);
-							y1++;
-							if (y1 == y2) break;
-							e += dx;
-							if (e <= 0) {
-								x1--;
-								e += dy;
-							}
-						}
-					}
-				} else {
-					// dy < 0 (et dx < 0)
-					// vecteur oblique dans le 3e cadran
-                    if (dx <= dy) {
-						// vecteur diagonal ou oblique proche de l’horizontale, dans le 5e octant
-						e = dx;
-						dx = 2*e;
-						dy = 2*dy;
-						while (1) {
-							set_pixel_(pixels, bytes_per_row, x1, y1);
-							x1--;
-							if (x1 == x2) break;
-							e -= dy;
-							if (e >= 0) {
-								y1--;
-								e += dx;
-							}
-						}
-					} else {
-						// vecteur oblique proche de la verticale, dans le 6e octant
-						e = dy;
-						dy = 2*e;
-						dx = 2*dx;
-						while (1) {
-							set_pixel_(pixels, bytes_per_row, x1, y1);
-							y1--;
-							if (y1 == y2) break;
-							e -= dx;
-							if (e >= 0) {
-								x1--;
-								e += dy;
-							}
-						}
-					}
-				}
-			} else {
-				// dy = 0 (et dx < 0)
-				// vecteur horizontal vers la gauche
-				while (1) {
-					set_pixel_(pixels, bytes_per_row, x1, y1);
-					x1--;
-					if (x1 == x2) break;
-				}
+			d = d + 2*y - 2*x - 2;
+			y--;
+			x++;
+		}
+	}
+}
+
+static void fill_circle_(GBitmap* bitmap, GPoint center, uint16_t radius, GColor8 fill_color){
+	bmpFillCircle(bitmap, center, radius-1, fill_color);
+	draw_circle_(bitmap, center, radius, fill_color);
+}
+
+void graphics_fill_circle_antialiased(GContext* ctx, GPoint center, uint16_t radius, GColor8 fill_color){
+	GBitmap* bitmap = graphics_capture_frame_buffer(ctx);
+	fill_circle_(bitmap, center, radius, fill_color);
+	graphics_release_frame_buffer(ctx, bitmap);
+}
+
+/**
+ * Scanline polygon rasterizer
+ * Coordinates are fixed points and pixel (x, y) covers [x, x+1[ x [y, y+1[, so a GPoint
+ * is at the center of its pixel. Like font rasterizers, each edge adds the signed area it
+ * leaves on its right to a per row accumulation buffer : the running sum of the buffer is
+ * the exact coverage of every pixel of the row (non-zero winding rule).
+ */
+
+// Inside a row the positions along the edges keep 8 fractional bits
+#define precise_1 0x100
+#define fixed_to_precise(f) ((f) << 4)
+
+// Accumulated area of a fully covered pixel : precise_1 high times 2 * precise_1 wide
+#define COVERAGE_FULL (2 * precise_1 * precise_1)
+
+typedef struct {
+	fixed x;
+	fixed y;
+} FPoint;
+
+#define gpoint_to_fpoint_(p) ((FPoint){int_to_fixed((p).x) + fixed_05, int_to_fixed((p).y) + fixed_05})
+
+typedef struct {
+	fixed x0, y0;     // top end
+	fixed x1, y1;     // bottom end, y1 > y0
+	int8_t winding;   // 1 going down, -1 going up
+} PolygonEdge;
+
+typedef struct {
+	PolygonEdge* edges;
+	uint16_t num_edges;
+	uint16_t max_edges;
+	fixed min_x, min_y, max_x, max_y;
+	FPoint first;     // first point of the current contour
+	FPoint last;      // last point of the current contour
+	bool failed;      // out of memory, the polygon is not drawn
+} Polygon;
+
+typedef struct {
+	const Polygon* polygon;
+	uint16_t* active;
+	uint16_t num_active;
+	uint16_t next;
+} PolygonScanner;
+
+static void polygon_init_(Polygon* polygon){
+	memset(polygon, 0, sizeof(Polygon));
+	polygon->min_x = polygon->min_y = INT32_MAX;
+	polygon->max_x = polygon->max_y = INT32_MIN;
+}
+
+static void polygon_deinit_(Polygon* polygon){
+	free(polygon->edges);
+	polygon->edges = NULL;
+}
+
+static void polygon_add_edge_(Polygon* polygon, FPoint a, FPoint b){
+	if(a.x < polygon->min_x) polygon->min_x = a.x;
+	if(a.x > polygon->max_x) polygon->max_x = a.x;
+	if(a.y < polygon->min_y) polygon->min_y = a.y;
+	if(a.y > polygon->max_y) polygon->max_y = a.y;
+	if(b.x < polygon->min_x) polygon->min_x = b.x;
+	if(b.x > polygon->max_x) polygon->max_x = b.x;
+	if(b.y < polygon->min_y) polygon->min_y = b.y;
+	if(b.y > polygon->max_y) polygon->max_y = b.y;
+
+	// Horizontal edges never cross a scanline
+	if(a.y == b.y)
+		return;
+
+	if(polygon->failed)
+		return;
+	if(polygon->num_edges == polygon->max_edges){
+		uint32_t max_edges = polygon->max_edges * 2 + 8;
+		if(max_edges > UINT16_MAX)
+			max_edges = UINT16_MAX;
+		PolygonEdge* edges = max_edges > polygon->num_edges ? realloc(polygon->edges, sizeof(PolygonEdge) * max_edges) : NULL;
+		if(!edges){
+			polygon->failed = true;
+			return;
+		}
+		polygon->edges = edges;
+		polygon->max_edges = max_edges;
+	}
+
+	PolygonEdge* edge = &polygon->edges[polygon->num_edges++];
+	if(a.y < b.y){
+		*edge = (PolygonEdge){a.x, a.y, b.x, b.y, 1};
+	}
+	else {
+		*edge = (PolygonEdge){b.x, b.y, a.x, a.y, -1};
+	}
+}
+
+static void polygon_move_to_(Polygon* polygon, FPoint p){
+	polygon->first = polygon->last = p;
+}
+
+static void polygon_line_to_(Polygon* polygon, FPoint p){
+	polygon_add_edge_(polygon, polygon->last, p);
+	polygon->last = p;
+}
+
+static void polygon_close_(Polygon* polygon){
+	polygon_line_to_(polygon, polygon->first);
+}
+
+static void polygon_add_contour_(Polygon* polygon, const FPoint* points, uint32_t num_points){
+	if(num_points < 2)
+		return;
+	polygon_move_to_(polygon, points[0]);
+	for(uint32_t i=1; i<num_points; i++)
+		polygon_line_to_(polygon, points[i]);
+	polygon_close_(polygon);
+}
+
+static int32_t isqrt_(int32_t n){
+	int32_t root = 0;
+	int32_t bit = 1 << 30;
+	while(bit > n)
+		bit >>= 2;
+	while(bit != 0){
+		if(n >= root + bit){
+			n -= root + bit;
+			root = (root >> 1) + bit;
+		}
+		else {
+			root >>= 1;
+		}
+		bit >>= 2;
+	}
+	return root;
+}
+
+// Normals are scaled to NORMAL_ONE to keep some precision in the joins
+#define NORMAL_ONE 256
+
+static FPoint edge_normal_(FPoint a, FPoint b, int32_t orientation){
+	int32_t dx = b.x - a.x;
+	int32_t dy = b.y - a.y;
+	int32_t len = isqrt_(dx * dx + dy * dy);
+	if(len == 0)
+		return (FPoint){0, 0};
+	return (FPoint){div_round(orientation * dy * NORMAL_ONE, len), div_round(-orientation * dx * NORMAL_ONE, len)};
+}
+
+// Rotates and moves the points of the path, consecutive duplicates are dropped.
+// Returns the number of points written in out, which must hold path->num_points points.
+static uint32_t path_to_fpoints_(GPath* path, bool closed, FPoint* out){
+	int32_t s = sin_lookup(path->rotation);
+	int32_t c = cos_lookup(path->rotation);
+	FPoint offset = gpoint_to_fpoint_(path->offset);
+
+	uint32_t count = 0;
+	for(uint32_t i=0; i<path->num_points; i++){
+		GPoint p = path->points[i];
+		FPoint fp;
+		fp.x = int_to_fixed(p.x * c - p.y * s) / TRIG_MAX_RATIO + offset.x;
+		fp.y = int_to_fixed(p.x * s + p.y * c) / TRIG_MAX_RATIO + offset.y;
+		if(count == 0 || fp.x != out[count - 1].x || fp.y != out[count - 1].y)
+			out[count++] = fp;
+	}
+	while(closed && count > 1 && out[count - 1].x == out[0].x && out[count - 1].y == out[0].y)
+		count--;
+	return count;
+}
+
+static bool polygon_scanner_init_(PolygonScanner* scanner, Polygon* polygon){
+	// Sort the edges by their top end (shell sort)
+	PolygonEdge* edges = polygon->edges;
+	for(uint16_t gap = polygon->num_edges / 2; gap > 0; gap /= 2){
+		for(uint16_t i=gap; i<polygon->num_edges; i++){
+			PolygonEdge edge = edges[i];
+			uint16_t j = i;
+			for(; j >= gap && edges[j - gap].y0 > edge.y0; j -= gap)
+				edges[j] = edges[j - gap];
+			edges[j] = edge;
+		}
+	}
+
+	scanner->polygon 	= polygon;
+	scanner->num_active = 0;
+	scanner->next 		= 0;
+	scanner->active 	= malloc(sizeof(uint16_t) * (polygon->num_edges + 1));
+	return scanner->active != NULL;
+}
+
+static void polygon_scanner_deinit_(PolygonScanner* scanner){
+	free(scanner->active);
+}
+
+// Adds the area on the right of the part of an edge inside a row, from xa at its top to xb
+// at its bottom, relative to the left of the row. Everything is in 1/precise_1 pixels. The area of each
+// pixel crossed by the edge is split between this pixel and the next one, the part on the
+// left of the edge only counts for the next pixels.
+static void coverage_add_edge_(int32_t* coverage, int16_t w, int32_t xa, int32_t xb, int32_t height, int8_t winding){
+	if(xa > xb){
+		int32_t x = xa;
+		xa = xb;
+		xb = x;
+	}
+
+	int32_t dx = xb - xa;
+	int32_t x = xa;
+	int32_t y = 0;
+
+	// Everything on the left of the row counts for all its pixels
+	if(x < 0){
+		int32_t x_end = xb < 0 ? xb : 0;
+		int32_t y_end = dx == 0 ? height : (x_end - xa) * height / dx;
+		coverage[0] += winding * (y_end - y) * 2 * precise_1;
+		x = x_end;
+		y = y_end;
+		if(x >= xb)
+			return;
+	}
+
+	for(int16_t cell = x / precise_1; cell < w; cell++){
+		int32_t cell_end = (cell + 1) * precise_1;
+		int32_t x_end = xb < cell_end ? xb : cell_end;
+		int32_t y_end = x_end >= xb ? height : (x_end - xa) * height / dx;
+		int32_t h = winding * (y_end - y);
+
+		// Twice the distance between the middle of the piece and the left of the pixel
+		int32_t middle = x + x_end - 2 * cell * precise_1;
+		coverage[cell] 		+= h * (2 * precise_1 - middle);
+		coverage[cell + 1] 	+= h * middle;
+
+		if(x_end >= xb)
+			break;
+		x = x_end;
+		y = y_end;
+	}
+}
+
+// Computes the coverage, from 0 to fixed_1, of the w pixels of row y starting at x0.
+// Rows must be scanned from top to bottom and coverage must hold w + 2 values.
+static void polygon_scan_row_(PolygonScanner* scanner, int16_t y, int16_t x0, int16_t w, int32_t* coverage){
+	const PolygonEdge* edges = scanner->polygon->edges;
+	fixed row_top = int_to_fixed(y);
+	fixed row_bottom = row_top + fixed_1;
+	fixed left = int_to_fixed(x0);
+
+	memset(coverage, 0, sizeof(int32_t) * (w + 2));
+
+	// Drop the edges above this row and activate the ones reaching it
+	uint16_t num_active = 0;
+	for(uint16_t i=0; i<scanner->num_active; i++){
+		if(edges[scanner->active[i]].y1 > row_top)
+			scanner->active[num_active++] = scanner->active[i];
+	}
+	while(scanner->next < scanner->polygon->num_edges && edges[scanner->next].y0 < row_bottom){
+		if(edges[scanner->next].y1 > row_top)
+			scanner->active[num_active++] = scanner->next;
+		scanner->next++;
+	}
+	scanner->num_active = num_active;
+
+	for(uint16_t i=0; i<num_active; i++){
+		const PolygonEdge* edge = &edges[scanner->active[i]];
+
+		// Part of the edge inside the row
+		fixed top = edge->y0 > row_top ? edge->y0 : row_top;
+		fixed bottom = edge->y1 < row_bottom ? edge->y1 : row_bottom;
+		int32_t edge_x = fixed_to_precise(edge->x0 - left);
+		int32_t xa = edge_x + fixed_to_precise(top - edge->y0) * (edge->x1 - edge->x0) / (edge->y1 - edge->y0);
+		int32_t xb = edge_x + fixed_to_precise(bottom - edge->y0) * (edge->x1 - edge->x0) / (edge->y1 - edge->y0);
+		coverage_add_edge_(coverage, w, xa, xb, fixed_to_precise(bottom - top), edge->winding);
+	}
+
+	int32_t sum = 0;
+	for(int16_t x=0; x<w; x++){
+		sum += coverage[x];
+		int32_t area = sum < 0 ? -sum : sum;
+		coverage[x] = area >= COVERAGE_FULL ? fixed_1 : (area * fixed_1 + COVERAGE_FULL / 2) / COVERAGE_FULL;
+	}
+}
+
+// Pixel rows and columns touched by the polygon, clipped to the bitmap.
+// Returns false if there is nothing to draw.
+static bool polygon_clip_(const Polygon* polygon, GBitmap* bitmap, int16_t* x0, int16_t* y0, int16_t* x1, int16_t* y1){
+	if(polygon->num_edges == 0)
+		return false;
+
+	GRect bounds = gbitmap_get_bounds(bitmap);
+	*x0 = fixed_to_int(polygon->min_x);
+	*y0 = fixed_to_int(polygon->min_y);
+	*x1 = fixed_to_int(polygon->max_x);
+	*y1 = fixed_to_int(polygon->max_y);
+	if(*x0 < bounds.origin.x) *x0 = bounds.origin.x;
+	if(*y0 < bounds.origin.y) *y0 = bounds.origin.y;
+	if(*x1 > bounds.origin.x + bounds.size.w - 1) *x1 = bounds.origin.x + bounds.size.w - 1;
+	if(*y1 > bounds.origin.y + bounds.size.h - 1) *y1 = bounds.origin.y + bounds.size.h - 1;
+	return *x0 <= *x1 && *y0 <= *y1;
+}
+
+// Fills the fill polygon and draws the stroke polygon over it in a single pass per row, every
+// pixel is written once. Without stroke polygon only the fill polygon is drawn.
+// A transparent fill color leaves the interior untouched.
+static void polygon_draw_(GBitmap* bitmap, Polygon* fill, Polygon* stroke, GColor8 fill_color, GColor8 stroke_color){
+	int16_t x0, y0, x1, y1;
+	if(fill->failed || (stroke && stroke->failed))
+		return;
+	if(!polygon_clip_(stroke ? stroke : fill, bitmap, &x0, &y0, &x1, &y1))
+		return;
+
+	uint8_t* pixels = gbitmap_get_data(bitmap);
+	uint16_t stride	= gbitmap_get_bytes_per_row(bitmap);
+	int16_t  w 		= x1 - x0 + 1;
+	bool     filled = fill_color.a != 0;
+
+	PolygonScanner fill_scanner, stroke_scanner;
+	int32_t* fill_coverage = malloc(sizeof(int32_t) * (w + 2));
+	int32_t* stroke_coverage = stroke ? malloc(sizeof(int32_t) * (w + 2)) : NULL;
+	bool ok = fill_coverage && (!stroke || stroke_coverage);
+	ok = polygon_scanner_init_(&fill_scanner, fill) && ok;
+	ok = (!stroke || polygon_scanner_init_(&stroke_scanner, stroke)) && ok;
+
+	for(int16_t y=y0; ok && y<=y1; y++){
+		polygon_scan_row_(&fill_scanner, y, x0, w, fill_coverage);
+		if(stroke)
+			polygon_scan_row_(&stroke_scanner, y, x0, w, stroke_coverage);
+
+		GColor8* row = (GColor8*)(pixels + x0 + stride * y);
+		for(int16_t x=0; x<w; x++){
+			fixed inner = filled ? fill_coverage[x] : 0;
+			fixed outer = stroke ? stroke_coverage[x] : 0;
+			if(inner == 0 && outer == 0)
+				continue;
+
+			if(outer >= fixed_1){
+				// Solid run of the stroke
+				int16_t end = x + 1;
+				while(end < w && stroke_coverage[end] >= fixed_1)
+					end++;
+				memset(row + x, stroke_color.argb, end - x);
+				x = end - 1;
+			}
+			else if(inner >= fixed_1 && outer == 0){
+				// Solid run of the interior
+				int16_t end = x + 1;
+				while(end < w && fill_coverage[end] >= fixed_1 && (!stroke || stroke_coverage[end] == 0))
+					end++;
+				memset(row + x, fill_color.argb, end - x);
+				x = end - 1;
+			}
+			else {
+				// The stroke covers the fill
+				blend_pixel_pair_(row + x, stroke_color, outer, fill_color, inner > outer ? inner - outer : 0);
 			}
 		}
-	} else {
-		// dx = 0
-		if ((dy = y2-y1) != 0) {
-			if (dy > 0) {
-				// vecteur vertical croissant
-				while (1) {
-					set_pixel_(pixels, bytes_per_row, x1, y1);
-					y1++;
-					if (y1 == y2) break;
-				}
-			} else {
-				// dy < 0 (et dx = 0)
-				// vecteur vertical décroissant
-				while (1) {
-					set_pixel_(pixels, bytes_per_row, x1, y1);
-					y1--;
-					if (y1 == y2) break;
-				}
-            }
+	}
+
+	free(fill_coverage);
+	free(stroke_coverage);
+	polygon_scanner_deinit_(&fill_scanner);
+	if(stroke)
+		polygon_scanner_deinit_(&stroke_scanner);
+}
+
+static void fill_fpoints_(GBitmap* bitmap, const FPoint* points, uint32_t num_points, GColor8 fill_color){
+	Polygon polygon;
+	polygon_init_(&polygon);
+	polygon_add_contour_(&polygon, points, num_points);
+	polygon_draw_(bitmap, &polygon, NULL, fill_color, fill_color);
+	polygon_deinit_(&polygon);
+}
+
+// Drawing the gpath filled with Pebble's gpath_draw_filled and then its antialiased outline
+// leaves, sometimes, some pixels between the outline and the interior of the form, and the
+// outline only approximates the coverage of the edges. So the path is filled with the exact
+// coverage of its pixels instead, in a single pass.
+static void draw_path_filled_(GBitmap* bitmap, GPath *path, GColor8 fill_color){
+	if(path->num_points < 2)
+		return;
+
+	FPoint* points = malloc(sizeof(FPoint) * path->num_points);
+	if(!points)
+		return;
+	uint32_t num_points = path_to_fpoints_(path, true, points);
+	fill_fpoints_(bitmap, points, num_points, fill_color);
+	free(points);
+}
+
+void gpath_draw_filled_antialiased(GContext* ctx, GPath *path, GColor8 fill_color){
+	GBitmap* bitmap = graphics_capture_frame_buffer(ctx);
+	draw_path_filled_(bitmap, path, fill_color);
+	graphics_release_frame_buffer(ctx, bitmap);
+}
+
+/**
+ * Thick strokes
+ * A stroke is one polygon made of the union of its segments, joins and caps. All the pieces
+ * are oriented the same way so the non-zero winding rule merges them, and the interior is
+ * drawn once as solid spans whatever the number of pieces.
+ */
+
+// Adds a convex contour, reversed if needed so that every piece has the same orientation
+static void polygon_add_convex_(Polygon* polygon, const FPoint* points, uint8_t num_points){
+	int64_t area = 0;
+	for(uint8_t i=0; i<num_points; i++){
+		FPoint a = points[i];
+		FPoint b = points[(i + 1) % num_points];
+		area += (int64_t)a.x * b.y - (int64_t)b.x * a.y;
+	}
+	if(area == 0)
+		return;
+
+	polygon_move_to_(polygon, points[area > 0 ? 0 : num_points - 1]);
+	for(uint8_t i=1; i<num_points; i++)
+		polygon_line_to_(polygon, points[area > 0 ? i : num_points - 1 - i]);
+	polygon_close_(polygon);
+}
+
+// Adds a circle, in the opposite orientation when it is a hole
+static void polygon_add_circle_(Polygon* polygon, FPoint center, fixed radius, bool hole){
+	if(radius <= 0)
+		return;
+
+	uint16_t sections = 8 + 8 * isqrt_(fixed_to_int(radius));
+	if(sections > 128)
+		sections = 128;
+
+	for(uint16_t i=0; i<sections; i++){
+		int32_t angle = (hole ? sections - i : i) * TRIG_MAX_ANGLE / sections;
+		FPoint p;
+		p.x = center.x + radius * cos_lookup(angle) / TRIG_MAX_RATIO;
+		p.y = center.y + radius * sin_lookup(angle) / TRIG_MAX_RATIO;
+		if(i == 0)
+			polygon_move_to_(polygon, p);
+		else
+			polygon_line_to_(polygon, p);
+	}
+	polygon_close_(polygon);
+}
+
+static void polygon_add_segment_(Polygon* polygon, FPoint a, FPoint b, fixed half_width, bool extend_a, bool extend_b){
+	int32_t dx = b.x - a.x;
+	int32_t dy = b.y - a.y;
+	int32_t len = isqrt_(dx * dx + dy * dy);
+	if(len == 0)
+		return;
+
+	// Direction of the segment scaled to the half width, rounded so the stroke keeps its width
+	fixed ux = div_round(dx * half_width, len);
+	fixed uy = div_round(dy * half_width, len);
+	if(extend_a){
+		a.x -= ux;
+		a.y -= uy;
+	}
+	if(extend_b){
+		b.x += ux;
+		b.y += uy;
+	}
+
+	FPoint quad[4] = {
+		{a.x - uy, a.y + ux},
+		{b.x - uy, b.y + ux},
+		{b.x + uy, b.y - ux},
+		{a.x + uy, a.y - ux}
+	};
+	polygon_add_convex_(polygon, quad, 4);
+}
+
+// Fills the gap left by the segment quads on the outer side of the turn at v
+static void polygon_add_join_(Polygon* polygon, FPoint prev, FPoint v, FPoint next, fixed half_width, AALineJoin join){
+	if(join == AALineJoinRound){
+		polygon_add_circle_(polygon, v, half_width, false);
+		return;
+	}
+
+	FPoint n0 = edge_normal_(prev, v, 1);
+	FPoint n1 = edge_normal_(v, next, 1);
+	int32_t turn = n0.x * (next.x - v.x) + n0.y * (next.y - v.y);
+	if(turn == 0)
+		return;
+	int32_t side = turn > 0 ? -1 : 1;
+
+	FPoint wedge[4];
+	uint8_t count = 0;
+	wedge[count++] = v;
+	wedge[count++] = (FPoint){v.x + div_round(side * n0.x * half_width, NORMAL_ONE), v.y + div_round(side * n0.y * half_width, NORMAL_ONE)};
+	int32_t denominator = NORMAL_ONE * NORMAL_ONE + n0.x * n1.x + n0.y * n1.y;
+	if(denominator * 8 >= NORMAL_ONE * NORMAL_ONE){
+		// Miter up to 4 times the half width, beveled beyond
+		wedge[count].x = v.x + div_round(side * (n0.x + n1.x) * half_width * NORMAL_ONE, denominator);
+		wedge[count].y = v.y + div_round(side * (n0.y + n1.y) * half_width * NORMAL_ONE, denominator);
+		count++;
+	}
+	wedge[count++] = (FPoint){v.x + div_round(side * n1.x * half_width, NORMAL_ONE), v.y + div_round(side * n1.y * half_width, NORMAL_ONE)};
+	polygon_add_convex_(polygon, wedge, count);
+}
+
+// Adds the stroke of a polyline, caps are only used by open polylines
+static void polygon_add_stroke_(Polygon* polygon, const FPoint* points, uint32_t num_points, bool closed, 
+	uint8_t stroke_width, AALineCap cap, AALineJoin join){
+	fixed half_width = int_to_fixed(stroke_width) / 2;
+	if(num_points == 0 || half_width == 0)
+		return;
+
+	if(num_points == 1 || (closed && num_points == 2)){
+		closed = false;
+	}
+
+	if(num_points == 1){
+		// A dot, only visible with round or square caps
+		FPoint p = points[0];
+		if(cap == AALineCapRound){
+			polygon_add_circle_(polygon, p, half_width, false);
+		}
+		else if(cap == AALineCapSquare){
+			FPoint square[4] = {
+				{p.x - half_width, p.y - half_width},
+				{p.x + half_width, p.y - half_width},
+				{p.x + half_width, p.y + half_width},
+				{p.x - half_width, p.y + half_width}
+			};
+			polygon_add_convex_(polygon, square, 4);
 		}
+		return;
+	}
+
+	uint32_t num_segments = closed ? num_points : num_points - 1;
+	for(uint32_t i=0; i<num_segments; i++){
+		bool first = !closed && i == 0;
+		bool last = !closed && i == num_segments - 1;
+		polygon_add_segment_(polygon, points[i], points[(i + 1) % num_points], half_width, 
+			first && cap == AALineCapSquare, last && cap == AALineCapSquare);
+	}
+
+	for(uint32_t i=(closed ? 0 : 1); i<(closed ? num_points : num_points - 1); i++){
+		polygon_add_join_(polygon, points[(i + num_points - 1) % num_points], points[i], points[(i + 1) % num_points], half_width, join);
+	}
+
+	if(!closed && cap == AALineCapRound){
+		polygon_add_circle_(polygon, points[0], half_width, false);
+		polygon_add_circle_(polygon, points[num_points - 1], half_width, false);
 	}
 }
 
-#define increase_queue_size(queue, max_size) \
-GPoint *tmp_queue = malloc(sizeof(GPoint) * (max_size + 1)); \
-memcpy(tmp_queue, queue, sizeof(GPoint) * max_size); \
-max_size++; \
-free(queue); \
-queue = tmp_queue; 
+static void draw_stroke_(GBitmap* bitmap, const FPoint* points, uint32_t num_points, bool closed, 
+	uint8_t stroke_width, AALineCap cap, AALineJoin join, GColor8 stroke_color){
+	Polygon polygon;
+	polygon_init_(&polygon);
+	polygon_add_stroke_(&polygon, points, num_points, closed, stroke_width, cap, join);
+	polygon_draw_(bitmap, &polygon, NULL, stroke_color, stroke_color);
+	polygon_deinit_(&polygon);
+}
+
+static void draw_path_stroke_(GBitmap* bitmap, GPath *path, bool closed, uint8_t stroke_width, AALineCap cap, AALineJoin join, GColor8 stroke_color){
+	if(path->num_points == 0)
+		return;
+
+	FPoint* points = malloc(sizeof(FPoint) * path->num_points);
+	if(!points)
+		return;
+	uint32_t num_points = path_to_fpoints_(path, closed, points);
+	draw_stroke_(bitmap, points, num_points, closed, stroke_width, cap, join, stroke_color);
+	free(points);
+}
+
+void gpath_draw_antialiased(GContext* ctx, GPath *path, GColor8 fill_color, GColor8 stroke_color, uint8_t stroke_width){
+	if(path->num_points < 2)
+		return;
+
+	// Transform the path once for both the fill and the stroke
+	FPoint* points = malloc(sizeof(FPoint) * path->num_points);
+	if(!points)
+		return;
+	uint32_t num_points = path_to_fpoints_(path, true, points);
+
+	// The stroke is centered on the path and drawn over the fill, so the parts of the shape
+	// thinner than the stroke only get the stroke color
+	Polygon fill, stroke;
+	polygon_init_(&fill);
+	polygon_init_(&stroke);
+	polygon_add_contour_(&fill, points, num_points);
+	if(stroke_width > 0 && stroke_color.a != 0)
+		polygon_add_stroke_(&stroke, points, num_points, true, stroke_width, AALineCapButt, AALineJoinMiter);
+	free(points);
+
+	GBitmap* bitmap = graphics_capture_frame_buffer(ctx);
+	polygon_draw_(bitmap, &fill, stroke.num_edges > 0 ? &stroke : NULL, fill_color, stroke_color);
+	graphics_release_frame_buffer(ctx, bitmap);
+
+	polygon_deinit_(&fill);
+	polygon_deinit_(&stroke);
+}
+
+void graphics_draw_thick_line_antialiased(GContext* ctx, GPoint p0, GPoint p1, uint8_t stroke_width, AALineCap cap, GColor8 stroke_color){
+	FPoint points[2] = {gpoint_to_fpoint_(p0), gpoint_to_fpoint_(p1)};
+	GBitmap* bitmap = graphics_capture_frame_buffer(ctx);
+	draw_stroke_(bitmap, points, gpoint_equal(&p0, &p1) ? 1 : 2, false, stroke_width, cap, AALineJoinMiter, stroke_color);
+	graphics_release_frame_buffer(ctx, bitmap);
+}
+
+void gpath_draw_thick_outline_antialiased(GContext* ctx, GPath *path, uint8_t stroke_width, AALineJoin join, GColor8 stroke_color){
+	GBitmap* bitmap = graphics_capture_frame_buffer(ctx);
+	draw_path_stroke_(bitmap, path, true, stroke_width, AALineCapButt, join, stroke_color);
+	graphics_release_frame_buffer(ctx, bitmap);
+}
+
+void gpath_draw_thick_outline_open_antialiased(GContext* ctx, GPath *path, uint8_t stroke_width, AALineCap cap, AALineJoin join, GColor8 stroke_color){
+	GBitmap* bitmap = graphics_capture_frame_buffer(ctx);
+	draw_path_stroke_(bitmap, path, false, stroke_width, cap, join, stroke_color);
+	graphics_release_frame_buffer(ctx, bitmap);
+}
+
+void graphics_draw_thick_circle_antialiased(GContext* ctx, GPoint center, uint16_t radius, uint8_t stroke_width, GColor8 stroke_color){
+	fixed half_width = int_to_fixed(stroke_width) / 2;
+	if(half_width == 0)
+		return;
+
+	// A ring, the inner circle is a hole
+	Polygon polygon;
+	polygon_init_(&polygon);
+	polygon_add_circle_(&polygon, gpoint_to_fpoint_(center), int_to_fixed(radius) + half_width, false);
+	polygon_add_circle_(&polygon, gpoint_to_fpoint_(center), int_to_fixed(radius) - half_width, true);
+
+	GBitmap* bitmap = graphics_capture_frame_buffer(ctx);
+	polygon_draw_(bitmap, &polygon, NULL, stroke_color, stroke_color);
+	graphics_release_frame_buffer(ctx, bitmap);
+	polygon_deinit_(&polygon);
+}
 
 /**
- * Flood fill algorithm : http://en.wikipedia.org/wiki/Flood_fill
+ * Dials
+ * Ticks are butt capped thick segments centered on the center pixel. When their number is a
+ * multiple of 4 the dial is symmetric about both axes and both diagonals of this pixel, like
+ * the quadrants of a circle : only the ticks reaching the first octant (0 <= dy <= dx) are
+ * rasterized, once, and the coverage of each pixel of the octant is plotted 8 times.
  */
-static void floodFill(GBitmap* bitmap, uint8_t* pixels, int bytes_per_row, GPoint start, GPoint offset, GColor8 fill_color){
-	uint8_t* img_pixels = gbitmap_get_data(bitmap);
-	GRect bounds_bmp = gbitmap_get_bounds(bitmap);
-  	int16_t  w_bmp 	= bounds_bmp.size.w;
+struct AADial {
+	uint16_t inner_radius;
+	uint16_t outer_radius;
+	uint16_t count;
+	uint8_t  width;
+	int16_t  size;        // the octant holds the offsets 0 <= dy <= dx < size
+	uint8_t* coverage;    // row dy holds the size - dy values from dx = dy, NULL to rasterize every tick
+};
+
+#define dial_row_(dial, dy) ((dial)->coverage + (dy) * (dial)->size - (dy) * ((dy) - 1) / 2)
+
+// Adds the ticks whose angle, from the x axis towards the y axis, is between min_angle and max_angle
+static void dial_add_ticks_(Polygon* polygon, const AADial* dial, FPoint center, int32_t min_angle, int32_t max_angle){
+	fixed half_width = int_to_fixed(dial->width) / 2;
+	fixed inner = int_to_fixed(dial->inner_radius);
+	fixed outer = int_to_fixed(dial->outer_radius);
+
+	for(uint16_t i=0; i<dial->count; i++){
+		int32_t angle = i * TRIG_MAX_ANGLE / dial->count;
+		if(angle > max_angle)
+			angle -= TRIG_MAX_ANGLE;
+		if(angle < min_angle || angle > max_angle)
+			continue;
+
+		int32_t cos = cos_lookup(angle);
+		int32_t sin = sin_lookup(angle);
+		FPoint a = {center.x + inner * cos / TRIG_MAX_RATIO, center.y + inner * sin / TRIG_MAX_RATIO};
+		FPoint b = {center.x + outer * cos / TRIG_MAX_RATIO, center.y + outer * sin / TRIG_MAX_RATIO};
+		polygon_add_segment_(polygon, a, b, half_width, false, false);
+	}
+}
 
-	uint32_t max_size = 6;
-	GPoint *queue = malloc(sizeof(GPoint) * max_size);
-	uint32_t size = 0;
+// Computes the coverage of the first octant, the dial is left without cache when out of memory
+static void dial_rasterize_octant_(AADial* dial){
+	fixed half_width = int_to_fixed(dial->width) / 2;
+	fixed inner = int_to_fixed(dial->inner_radius);
+
+	// A pixel of the octant is only touched by the ticks less than half the width plus half
+	// the diagonal of a pixel away from its center, within asin(reach / inner) of its angle
+	fixed reach = half_width + fixed_1;
+	int32_t margin = inner > reach ? atan2_lookup(reach, isqrt_(inner * inner - reach * reach)) : TRIG_MAX_ANGLE / 2;
+
+	Polygon polygon;
+	polygon_init_(&polygon);
+	dial_add_ticks_(&polygon, dial, (FPoint){fixed_05, fixed_05}, -margin, TRIG_MAX_ANGLE / 8 + margin);
+
+	int16_t size = dial->outer_radius + (dial->width + 1) / 2 + 2;
+	PolygonScanner scanner;
+	uint8_t* coverage = malloc(size * (size + 1) / 2);
+	int32_t* row = malloc(sizeof(int32_t) * (size + 2));
+	bool ok = coverage && row && !polygon.failed;
+	ok = polygon_scanner_init_(&scanner, &polygon) && ok;
+
+	if(ok){
+		dial->size = size;
+		dial->coverage = coverage;
+		for(int16_t dy=0; dy<size; dy++){
+			// Only the part of the row inside the octant
+			polygon_scan_row_(&scanner, dy, dy, size - dy, row);
+			uint8_t* octant = dial_row_(dial, dy);
+			for(int16_t dx=0; dx<size - dy; dx++)
+				octant[dx] = row[dx];
+		}
+	}
+	else {
+		free(coverage);
+	}
 
-	int32_t x = start.x - offset.x;
-	int32_t y = start.y - offset.y;
+	free(row);
+	polygon_scanner_deinit_(&scanner);
+	polygon_deinit_(&polygon);
+}
 
-	queue[size++] = (GPoint){x,y};
-	int32_t w,e;
+// Blends the pixel (dx, dy) of the octant and its distinct mirror images around the center
+static void dial_plot_(uint8_t* pixels, uint16_t stride, const GRect* clip, GPoint center, int16_t dx, int16_t dy, GColor8 color, fixed br){
+	_plot(pixels, stride, clip, center.x + dx, center.y + dy, color, br);
+	if(dx != 0)
+		_plot(pixels, stride, clip, center.x - dx, center.y + dy, color, br);
+	if(dy != 0){
+		_plot(pixels, stride, clip, center.x + dx, center.y - dy, color, br);
+		_plot(pixels, stride, clip, center.x - dx, center.y - dy, color, br);
+	}
+	if(dx == dy)
+		return;
 
-	while(size > 0)
-	{
-		size--;
-		x = queue[size].x;
-		y = queue[size].y;
-		w = e = x;
-
-		while(!get_pixel_(pixels, bytes_per_row, e, y))
-			e++;
-		while(w>=0 && !get_pixel_(pixels, bytes_per_row, w, y))
-			w--;
-
-		bool up = false;
-		bool down = false;
-		for(x=w+1; x<e; x++)
-		{	
-			// change the color of the pixel in the final image
-			if(grect_contains_point(&bounds_bmp,&((GPoint){x + offset.x, y + offset.y})))
-				img_pixels[x + offset.x + w_bmp * (y + offset.y)] = fill_color.argb;
-
-			set_pixel_(pixels, bytes_per_row,  x, y);
-
-			if(!get_pixel_(pixels, bytes_per_row, x, y+1)){
-				down = true;
-			}
-			else if(down) {
-				down = false;
-				if(size == max_size){
-					increase_queue_size(queue, max_size)
-				}
-				queue[size++] = (GPoint){x-1, y+1};
+	_plot(pixels, stride, clip, center.x + dy, center.y + dx, color, br);
+	_plot(pixels, stride, clip, center.x + dy, center.y - dx, color, br);
+	if(dy != 0){
+		_plot(pixels, stride, clip, center.x - dy, center.y + dx, color, br);
+		_plot(pixels, stride, clip, center.x - dy, center.y - dx, color, br);
+	}
+}
+
+static void dial_draw_(GBitmap* bitmap, const AADial* dial, GPoint center, GColor8 color){
+	if(!dial->coverage){
+		Polygon polygon;
+		polygon_init_(&polygon);
+		dial_add_ticks_(&polygon, dial, gpoint_to_fpoint_(center), -TRIG_MAX_ANGLE, TRIG_MAX_ANGLE);
+		polygon_draw_(bitmap, &polygon, NULL, color, color);
+		polygon_deinit_(&polygon);
+		return;
+	}
+
+	uint8_t* pixels = gbitmap_get_data(bitmap);
+	uint16_t stride	= gbitmap_get_bytes_per_row(bitmap);
+	GRect    clip 	= gbitmap_get_bounds(bitmap);
+
+	for(int16_t dy=0; dy<dial->size; dy++){
+		const uint8_t* row = dial_row_(dial, dy) - dy;
+		for(int16_t dx=dy; dx<dial->size; dx++){
+			if(row[dx] == 0)
+				continue;
+			if(row[dx] < fixed_1){
+				dial_plot_(pixels, stride, &clip, center, dx, dy, color, row[dx]);
+				continue;
 			}
 
-			if(!get_pixel_(pixels, bytes_per_row, x, y-1)){
-				up = true;
+			// Solid run, mirrored as spans of the rows center.y +/- dy and as columns center.x +/- dy
+			int16_t end = dx + 1;
+			while(end < dial->size && row[end] >= fixed_1)
+				end++;
+			bmpHLine(pixels, stride, &clip, center.x + dx, center.x + end - 1, center.y + dy, color);
+			bmpHLine(pixels, stride, &clip, center.x - end + 1, center.x - dx, center.y + dy, color);
+			if(dy != 0){
+				bmpHLine(pixels, stride, &clip, center.x + dx, center.x + end - 1, center.y - dy, color);
+				bmpHLine(pixels, stride, &clip, center.x - end + 1, center.x - dx, center.y - dy, color);
 			}
-			else if(up) {
-				up = false;
-				if(size == max_size){
-					increase_queue_size(queue, max_size)
+			for(int16_t k=(dx == dy ? dx + 1 : dx); k<end; k++){
+				_plot(pixels, stride, &clip, center.x + dy, center.y + k, color, fixed_1);
+				_plot(pixels, stride, &clip, center.x + dy, center.y - k, color, fixed_1);
+				if(dy != 0){
+					_plot(pixels, stride, &clip, center.x - dy, center.y + k, color, fixed_1);
+					_plot(pixels, stride, &clip, center.x - dy, center.y - k, color, fixed_1);
 				}
-				queue[size++] = (GPoint){x-1, y-1};
 			}
+			dx = end - 1;
 		}
-		if(down) {
-			down = false;
-			if(size == max_size){
-				increase_queue_size(queue, max_size)
+	}
+}
+
+AADial* aa_dial_create(uint16_t inner_radius, uint16_t outer_radius, uint16_t count, uint8_t width){
+	AADial* dial = malloc(sizeof(AADial));
+	if(!dial)
+		return NULL;
+
+	if(inner_radius > outer_radius)
+		swap_(inner_radius, outer_radius);
+	*dial = (AADial){inner_radius, outer_radius, count, width, 0, NULL};
+	if(count > 0 && count % 4 == 0)
+		dial_rasterize_octant_(dial);
+	return dial;
+}
+
+void aa_dial_destroy(AADial* dial){
+	if(!dial)
+		return;
+	free(dial->coverage);
+	free(dial);
+}
+
+void aa_dial_draw(GContext* ctx, const AADial* dial, GPoint center, GColor8 color){
+	GBitmap* bitmap = graphics_capture_frame_buffer(ctx);
+	dial_draw_(bitmap, dial, center, color);
+	graphics_release_frame_buffer(ctx, bitmap);
+}
+
+void graphics_draw_dial_antialiased(GContext* ctx, GPoint center, uint16_t inner_radius, uint16_t outer_radius, uint16_t count, uint8_t width, GColor8 color){
+	AADial* dial = aa_dial_create(inner_radius, outer_radius, count, width);
+	if(!dial)
+		return;
+	aa_dial_draw(ctx, dial, center, color);
+	aa_dial_destroy(dial);
+}
+
+/**
+ * Compact vector format (AAV) rendered without building GPath objects.
+ * The tools/aav_convert.py script generates it, every value is little endian.
+ *
+ *   header  : 'A' 'V' <version> <reserved> <uint16 number of contours>
+ *   contour : <flags> <fill color> <stroke color> <stroke width> <uint16 number of points>
+ *             [<one tag per point> <padding to an even size>]  only with AAV_FLAG_CURVES
+ *             <number of points * (int16 x, int16 y)>
+ *
+ * The points have the same layout as GPoint so they are drawn straight from the data.
+ * A contour with AAV_FLAG_CONTINUE is filled together with the previous one, with the fill
+ * color of the first contour of the group, so holes wound the other way are left empty.
+ */
+#define AAV_VERSION       1
+#define AAV_HEADER_SIZE   6
+#define AAV_CONTOUR_SIZE  6
+#define AAV_POINT_SIZE    4
+
+#define AAV_FLAG_FILL     0x01
+#define AAV_FLAG_STROKE   0x02
+#define AAV_FLAG_CLOSED   0x04
+#define AAV_FLAG_CURVES   0x08
+#define AAV_FLAG_CONTINUE 0x10   // filled with the previous contour, e.g. one of its holes
+
+#define AAV_TAG_CONTROL   0x01   // quadratic control point, on-curve otherwise
+
+#define AAV_STREAM_CHUNK  32     // number of points loaded at once when streaming an outline
+
+#define aav_read_u16_(b) ((uint16_t)((b)[0] | ((b)[1] << 8)))
+#define aav_tags_size_(contour) (((contour)->flags & AAV_FLAG_CURVES) ? ((contour)->num_points + 1) & ~1 : 0)
+
+typedef struct {
+	uint8_t  flags;
+	GColor8  fill_color;
+	GColor8  stroke_color;
+	uint8_t  stroke_width;
+	uint16_t num_points;
+} AAVContour;
+
+static bool aav_read_header_(const uint8_t* data, uint16_t* num_contours){
+	if(data[0] != 'A' || data[1] != 'V' || data[2] != AAV_VERSION)
+		return false;
+	*num_contours = aav_read_u16_(data + 4);
+	return true;
+}
+
+static void aav_read_contour_(const uint8_t* data, AAVContour* contour){
+	contour->flags 				= data[0];
+	contour->fill_color.argb 	= data[1];
+	contour->stroke_color.argb 	= data[2];
+	contour->stroke_width 		= data[3];
+	contour->num_points 		= aav_read_u16_(data + 4);
+}
+
+// Returns false if there is not enough memory, *points is then left unchanged
+static bool aav_push_point_(GPoint** points, uint32_t* size, uint32_t* count, GPoint p){
+	if(*count > 0 && (*points)[*count - 1].x == p.x && (*points)[*count - 1].y == p.y)
+		return true;
+	if(*count == *size){
+		GPoint* grown = realloc(*points, sizeof(GPoint) * (*size * 2 + 8));
+		if(!grown)
+			return false;
+		*points = grown;
+		*size = *size * 2 + 8;
+	}
+	(*points)[(*count)++] = p;
+	return true;
+}
+
+static bool aav_push_quad_(GPoint** points, uint32_t* size, uint32_t* count, GPoint p0, GPoint c, GPoint p1){
+	// One segment every 4 pixels of control polygon is enough on a watch screen
+	int32_t n = (abs(c.x - p0.x) + abs(c.y - p0.y) + abs(p1.x - c.x) + abs(p1.y - c.y)) / 4;
+	if(n < 2) 
+		n = 2;
+	if(n > 16) 
+		n = 16;
+
+	for(int32_t i=1; i<=n; i++){
+		int32_t a = n - i;
+		int32_t b = i;
+		GPoint p;
+		p.x = (p0.x * a * a + 2 * c.x * a * b + p1.x * b * b) / (n * n);
+		p.y = (p0.y * a * a + 2 * c.y * a * b + p1.y * b * b) / (n * n);
+		if(!aav_push_point_(points, size, count, p))
+			return false;
+	}
+	return true;
+}
+
+// Expands the quadratic curves of a contour into line segments, TrueType style :
+// two consecutive control points imply an on-curve point halfway between them.
+// Returns the number of points written in *out, which is grown as needed, 0 if there is not enough memory.
+static uint32_t aav_flatten_(const GPoint* points, const uint8_t* tags, uint16_t num_points, bool closed, GPoint** out, uint32_t* out_size){
+	uint16_t start = 0;
+	while(start < num_points && (tags[start] & AAV_TAG_CONTROL))
+		start++;
+	if(start == num_points)
+		return 0;
+
+	uint32_t count = 0;
+	GPoint prev = points[start];
+	GPoint control = prev;
+	bool pending = false;
+	bool ok = aav_push_point_(out, out_size, &count, prev);
+
+	uint16_t last = closed ? num_points : num_points - 1 - start;
+	for(uint16_t k=1; ok && k<=last; k++){
+		uint16_t i = (start + k) % num_points;
+		if(tags[i] & AAV_TAG_CONTROL){
+			if(pending){
+				GPoint mid = (GPoint){(control.x + points[i].x) / 2, (control.y + points[i].y) / 2};
+				ok = aav_push_quad_(out, out_size, &count, prev, control, mid);
+				prev = mid;
 			}
-			queue[size++] = (GPoint){x-1, y+1};
+			control = points[i];
+			pending = true;
 		}
-		if(up) {
-			up = false;
-			if(size == max_size){
-				increase_queue_size(queue, max_size)
-			}
-			queue[size++] = (GPoint){x-1, y-1};
+		else {
+			if(pending)
+				ok = aav_push_quad_(out, out_size, &count, prev, control, points[i]);
+			else
+				ok = aav_push_point_(out, out_size, &count, points[i]);
+			prev = points[i];
+			pending = false;
 		}
 	}
 
-	free(queue);
+	if(!ok)
+		return 0;
+
+	// The closing segment is implicit
+	if(closed && count > 1 && (*out)[count - 1].x == (*out)[0].x && (*out)[count - 1].y == (*out)[0].y)
+		count--;
+
+	return count;
 }
 
+// Adds a flattened contour to the fill of its group
+static void aav_add_fill_(Polygon* polygon, const GPoint* points, uint32_t num_points, GPoint offset){
+	if(num_points < 2)
+		return;
 
-static void gpath_draw_filled_custom(GContext* ctx, GPath *path, GColor8 fill_color){
-	if(path->num_points == 0)
-		return;	
+	FPoint foffset = gpoint_to_fpoint_(offset);
+	for(uint32_t i=0; i<num_points; i++){
+		FPoint p = {int_to_fixed(points[i].x) + foffset.x, int_to_fixed(points[i].y) + foffset.y};
+		if(i == 0)
+			polygon_move_to_(polygon, p);
+		else
+			polygon_line_to_(polygon, p);
+	}
+	polygon_close_(polygon);
+}
 
-	GPoint offset = path->offset;
-	int32_t rotation = path->rotation;
+static void aav_draw_stroke_(GBitmap* bitmap, const AAVContour* contour, const GPoint* points, uint32_t num_points, GPoint offset){
+	bool closed = contour->flags & (AAV_FLAG_CLOSED | AAV_FLAG_FILL);
+	if(contour->stroke_width <= 1){
+		draw_points_outline_(bitmap, points, num_points, closed, offset, contour->stroke_color);
+		return;
+	}
 
-	int32_t s = sin_lookup(rotation);
-  	int32_t c = cos_lookup(rotation);
+	FPoint* fpoints = malloc(sizeof(FPoint) * num_points);
+	if(!fpoints)
+		return;
+	FPoint foffset = gpoint_to_fpoint_(offset);
+	for(uint32_t i=0; i<num_points; i++)
+		fpoints[i] = (FPoint){int_to_fixed(points[i].x) + foffset.x, int_to_fixed(points[i].y) + foffset.y};
 
-  	// Rotate each point of the gpath and memorize the min/max
-	GPoint* points_rot = malloc(sizeof(GPoint) * path->num_points);
-	GPoint top_right = (GPoint){(1 << 15)-1,(1 << 15)-1};
-	GPoint bottom_left= (GPoint){-(1 << 15),-(1 << 15)};
-
-  	for(uint32_t i=0; i<path->num_points; i++){
-  		points_rot[i].x = (path->points[i].x * c - path->points[i].y * s) / TRIG_MAX_RATIO  + offset.x;
-		points_rot[i].y = (path->points[i].x * s + path->points[i].y * c) / TRIG_MAX_RATIO  + offset.y;
-		if(points_rot[i].x > bottom_left.x)
-			bottom_left.x = points_rot[i].x;
-		if(points_rot[i].x < top_right.x)
-			top_right.x = points_rot[i].x;
-		if(points_rot[i].y > bottom_left.y)
-			bottom_left.y = points_rot[i].y;
-		if(points_rot[i].y < top_right.y)
-			top_right.y = points_rot[i].y;
-  	}
-
-  	// Create an array bitmap pebble v2 style (1 bit equals 1 pixel)
-  	int32_t bytes_per_row = (bottom_left.x - top_right.x + 1) / 8 + ((bottom_left.x - top_right.x  + 1) % 8 == 0 ? 0 : 1);
-  	int32_t h = bottom_left.y - top_right.y + 1;
-  	uint8_t* pixels = malloc(bytes_per_row * h);
-  	memset(pixels, 0, bytes_per_row * h);
-
-  	// And draw the outline path in this 1 bit image
-  	GPoint prev_p = points_rot[path->num_points - 1];
-  	GPoint p;
-  	for(uint32_t i=0; i<path->num_points; i++){
-  		p = points_rot[i];
-  		bmpDrawLine(pixels, bytes_per_row, prev_p.x - top_right.x, prev_p.y - top_right.y, p.x - top_right.x, p.y - top_right.y);
-  		prev_p = p;
-  	}
+	// Same defaults as SVG : mitered joins and butt caps
+	draw_stroke_(bitmap, fpoints, num_points, closed, contour->stroke_width, AALineCapButt, AALineJoinMiter, contour->stroke_color);
+	free(fpoints);
+}
 
-  	free(points_rot);
+// Adds a contour whose tags and points are in memory to the fill of its group, or draws its
+// stroke when fill is NULL. Its curves are flattened in *flat if any.
+static void aav_draw_contour_data_(GBitmap* bitmap, Polygon* fill, const AAVContour* contour, const uint8_t* body, GPoint offset, GPoint** flat, uint32_t* flat_size){
+	const GPoint* points = (const GPoint*)(body + aav_tags_size_(contour));
+	uint32_t count = contour->num_points;
+	if(contour->flags & AAV_FLAG_CURVES){
+		bool closed = fill || (contour->flags & (AAV_FLAG_CLOSED | AAV_FLAG_FILL));
+		count = aav_flatten_(points, body, contour->num_points, closed, flat, flat_size);
+		points = *flat;
+	}
+	if(count == 0)
+		return;
 
-  	// Compute the starting point for the flow fill algorithm 
-  	// TODO tobe improved
-  	GPoint start;
-  	start.x = (points_rot[0].x + points_rot[1].x) / 2;
-  	start.y = (points_rot[0].y + points_rot[1].y) / 2;
+	if(fill)
+		aav_add_fill_(fill, points, count, offset);
+	else
+		aav_draw_stroke_(bitmap, contour, points, count, offset);
+}
 
-  	if(points_rot[0].x < points_rot[1].x){
-  		if(points_rot[0].y < points_rot[1].y){
-  			start.x--;
-  			start.y++;
-  		}
-  		else {
-  			start.x++;
-  			start.y++;
-  		}
-  	}
-  	else {
-  		if(points_rot[0].y < points_rot[1].y){
-  			start.x--;
-  			start.y--;
-  		}
-  		else {
-  			start.x++;
-  			start.y--;
-  		}
-  	}
+// Draws an outline only contour a few points at a time
+static void aav_stream_outline_(GBitmap* bitmap, ResHandle handle, uint32_t start, const AAVContour* contour, GPoint offset){
+	GPoint chunk[AAV_STREAM_CHUNK];
+	GPoint first = GPointZero;
+	GPoint prev = GPointZero;
+
+	for(uint16_t i=0; i<contour->num_points; i+=AAV_STREAM_CHUNK){
+		uint16_t count = contour->num_points - i < AAV_STREAM_CHUNK ? contour->num_points - i : AAV_STREAM_CHUNK;
+		if(resource_load_byte_range(handle, start + i * AAV_POINT_SIZE, (uint8_t*)chunk, count * AAV_POINT_SIZE) != count * AAV_POINT_SIZE)
+			return;
+
+		for(uint16_t j=0; j<count; j++){
+			if(i + j == 0)
+				first = chunk[j];
+			else
+				draw_line_antialias_(bitmap, prev.x + offset.x, prev.y + offset.y, chunk[j].x + offset.x, chunk[j].y + offset.y, contour->stroke_color);
+			prev = chunk[j];
+		}
+	}
 
-  	// Capture the frame buffer
-  	GBitmap* bitmap = graphics_capture_frame_buffer(ctx);
+	if((contour->flags & (AAV_FLAG_CLOSED | AAV_FLAG_FILL)) && contour->num_points > 1)
+		draw_line_antialias_(bitmap, prev.x + offset.x, prev.y + offset.y, first.x + offset.x, first.y + offset.y, contour->stroke_color);
+}
 
-  	// flood fill the gpath
-  	floodFill(bitmap, pixels, bytes_per_row, start, top_right, fill_color);
+// Reads AAV data from memory, or from a resource one contour at a time
+typedef struct {
+	const uint8_t* data;    // NULL to read from the resource
+	ResHandle handle;
+	size_t size;
+	uint8_t* body;          // last contour loaded from the resource
+	size_t body_max;
+} AAVReader;
+
+// Reads the contour at *pos and moves *pos to the next one. *body gets its tags and points, or
+// NULL for a resource when load is false. Returns false at the end of the data or when out of memory.
+static bool aav_read_next_(AAVReader* reader, size_t* pos, AAVContour* contour, const uint8_t** body, bool load){
+	uint8_t header[AAV_CONTOUR_SIZE];
+	if(*pos + AAV_CONTOUR_SIZE > reader->size)
+		return false;
+	if(reader->data){
+		aav_read_contour_(reader->data + *pos, contour);
+	}
+	else {
+		if(resource_load_byte_range(reader->handle, *pos, header, AAV_CONTOUR_SIZE) != AAV_CONTOUR_SIZE)
+			return false;
+		aav_read_contour_(header, contour);
+	}
 
-  	// Release the frame buffer
-  	graphics_release_frame_buffer(ctx, bitmap);  	
+	size_t start = *pos + AAV_CONTOUR_SIZE;
+	size_t body_size = aav_tags_size_(contour) + contour->num_points * AAV_POINT_SIZE;
+	if(start + body_size > reader->size)
+		return false;
+	*pos = start + body_size;
 
-  	//Release the working variables
-  	free(pixels);
+	*body = NULL;
+	if(reader->data){
+		*body = reader->data + start;
+	}
+	else if(load){
+		if(body_size > reader->body_max){
+			free(reader->body);
+			reader->body = malloc(body_size);
+			reader->body_max = reader->body ? body_size : 0;
+			if(!reader->body)
+				return false;
+		}
+		if(resource_load_byte_range(reader->handle, start, reader->body, body_size) != body_size)
+			return false;
+		*body = reader->body;
+	}
+	return true;
 }
 
+// Draws the contours in groups : a contour and the following ones continuing its fill, like
+// its holes, are filled at once so that the non-zero winding rule cuts the holes. The strokes
+// of the group are drawn over its fill.
+static void aav_draw_(GBitmap* bitmap, AAVReader* reader, uint16_t num_contours, GPoint offset){
+	GPoint* flat = NULL;
+	uint32_t flat_size = 0;
+	AAVContour first, contour;
+	const uint8_t* body;
+
+	size_t pos = AAV_HEADER_SIZE;
+	bool ok = true;
+	for(uint16_t c=0; ok && c<num_contours; ){
+		size_t group = pos;
+		if(!aav_read_next_(reader, &pos, &first, &body, false))
+			break;
+		uint16_t group_size = 1;
+		size_t next = pos;
+		while(c + group_size < num_contours 
+			&& aav_read_next_(reader, &next, &contour, &body, false) 
+			&& (contour.flags & AAV_FLAG_CONTINUE)){
+			pos = next;
+			group_size++;
+		}
+		c += group_size;
+
+		if(first.flags & AAV_FLAG_FILL){
+			Polygon polygon;
+			polygon_init_(&polygon);
+			size_t p = group;
+			for(uint16_t i=0; ok && i<group_size; i++){
+				ok = aav_read_next_(reader, &p, &contour, &body, true);
+				if(ok)
+					aav_draw_contour_data_(bitmap, &polygon, &contour, body, offset, &flat, &flat_size);
+			}
+			if(ok)
+				polygon_draw_(bitmap, &polygon, NULL, first.fill_color, first.fill_color);
+			polygon_deinit_(&polygon);
+		}
 
-// What I wanted to do here is to draw the gpath filled and draw the antialised outline like that :
-// 		gpath_draw_filled(ctx, path) 
-// 		gpath_draw_outline_antialiased(ctx, path) 
-// but with the current API (3.0 and older) when you draw a path filled and its outline, sometimes, some pixels are not drawn between
-// the outline and the interior of the form. That's not what I want...
-// So I've implemented my own gpath_draw_filled : gpath_draw_filled_custom
-void gpath_draw_filled_antialiased(GContext* ctx, GPath *path, GColor8 fill_color){
-	// draw the filled gpath
-	gpath_draw_filled_custom(ctx, path, fill_color);
-	// Draw the antialiased outline around the filled gpath
-	gpath_draw_outline_antialiased(ctx, path, fill_color);
+		size_t p = group;
+		for(uint16_t i=0; ok && i<group_size; i++){
+			size_t start = p;
+			ok = aav_read_next_(reader, &p, &contour, &body, false);
+			if(!ok || !(contour.flags & AAV_FLAG_STROKE))
+				continue;
+
+			if(!body && !(contour.flags & AAV_FLAG_CURVES) && contour.stroke_width <= 1){
+				// Only one chunk of a thin outline is in memory
+				aav_stream_outline_(bitmap, reader->handle, p - contour.num_points * AAV_POINT_SIZE, &contour, offset);
+				continue;
+			}
+			if(!body)
+				ok = aav_read_next_(reader, &start, &contour, &body, true);
+			if(ok)
+				aav_draw_contour_data_(bitmap, NULL, &contour, body, offset, &flat, &flat_size);
+		}
+	}
+
+	free(flat);
 }
 
+static void aav_draw_data_(GBitmap* bitmap, const uint8_t* data, size_t size, GPoint offset){
+	uint16_t num_contours;
+	if(size < AAV_HEADER_SIZE || !aav_read_header_(data, &num_contours))
+		return;
 
-void graphics_draw_circle_antialiased(GContext* ctx, GPoint center, uint16_t radius, GColor8 stroke_color){
+	AAVReader reader = {.data = data, .size = size};
+	aav_draw_(bitmap, &reader, num_contours, offset);
+}
 
+void gvector_draw_antialiased(GContext* ctx, const uint8_t* data, size_t size, GPoint offset){
 	GBitmap* bitmap = graphics_capture_frame_buffer(ctx);
+	aav_draw_data_(bitmap, data, size, offset);
+	graphics_release_frame_buffer(ctx, bitmap);
+}
 
-	uint8_t sections = 9; //TODO tweak that
-	GPoint prev_p = (GPoint){0,0};
-	GPoint p;
-	for (uint8_t i = 0; i < sections; i++)
-	{
-  		int32_t angle = i * TRIG_MAX_ANGLE / (4 *  (sections - 1) );
-  		int32_t s = sin_lookup(angle);
-  		int32_t c = cos_lookup(angle);
+void gvector_draw_resource_antialiased(GContext* ctx, uint32_t resource_id, GPoint offset){
+	ResHandle handle = resource_get_handle(resource_id);
+	size_t size = resource_size(handle);
 
-  		p.x = -radius * s / TRIG_MAX_RATIO;
-  		p.y =  radius * c / TRIG_MAX_RATIO;
+	uint8_t header[AAV_HEADER_SIZE];
+	uint16_t num_contours;
+	if(size < AAV_HEADER_SIZE 
+		|| resource_load_byte_range(handle, 0, header, AAV_HEADER_SIZE) != AAV_HEADER_SIZE
+		|| !aav_read_header_(header, &num_contours))
+		return;
 
-  		// p is the point in the top right quarter (between 0 and 90°)
-  		// by symmmetry we draw the other quarters
-  		if(i>0){
-  			draw_line_antialias_(bitmap, center.x + prev_p.x, center.y + prev_p.y, center.x + p.x, center.y + p.y, stroke_color);
-  			draw_line_antialias_(bitmap, center.x - prev_p.x, center.y + prev_p.y, center.x - p.x, center.y + p.y, stroke_color);
-  			draw_line_antialias_(bitmap, center.x + prev_p.x, center.y - prev_p.y, center.x + p.x, center.y - p.y, stroke_color);
-  			draw_line_antialias_(bitmap, center.x - prev_p.x, center.y - prev_p.y, center.x - p.x, center.y - p.y, stroke_color);
-  		}
+	// Only one contour at a time is loaded in memory
+	AAVReader reader = {.data = NULL, .handle = handle, .size = size};
+	GBitmap* bitmap = graphics_capture_frame_buffer(ctx);
+	aav_draw_(bitmap, &reader, num_contours, offset);
+	graphics_release_frame_buffer(ctx, bitmap);
+	free(reader.body);
+}
 
-  		prev_p = p;
+/**
+ * Time-sliced rendering of a list of primitives into an offscreen bitmap
+ */
+struct AARenderJob {
+	GBitmap* 		bitmap;
+	AAPrimitive* 	primitives;
+	uint16_t 		num_primitives;
+	uint16_t 		next;
+	AppTimer* 		timer;
+	uint32_t 		interval_ms;
+	uint32_t 		max_primitives;
+	uint32_t 		max_pixels;
+	AARenderJobCompletedHandler completed_handler;
+	void* 			context;
+};
+
+// Rough number of pixels touched by a vector image : the perimeter of each contour, times the
+// width of thick strokes, plus the bounding box of the filled contours. Quadratic curves are
+// no longer than their control polygon.
+static uint32_t aav_cost_(const uint8_t* data, size_t size){
+	uint16_t num_contours;
+	if(size < AAV_HEADER_SIZE || !aav_read_header_(data, &num_contours))
+		return 1;
+
+	uint32_t cost = 1;
+	size_t pos = AAV_HEADER_SIZE;
+	for(uint16_t c=0; c<num_contours && pos + AAV_CONTOUR_SIZE <= size; c++){
+		AAVContour contour;
+		aav_read_contour_(data + pos, &contour);
+		pos += AAV_CONTOUR_SIZE;
+
+		size_t body_size = aav_tags_size_(&contour) + contour.num_points * AAV_POINT_SIZE;
+		if(pos + body_size > size || contour.num_points == 0)
+			break;
+		const GPoint* points = (const GPoint*)(data + pos + aav_tags_size_(&contour));
+		pos += body_size;
+
+		uint32_t perimeter = 0;
+		int16_t min_x = points[0].x, max_x = min_x;
+		int16_t min_y = points[0].y, max_y = min_y;
+		GPoint prev = points[contour.num_points - 1];
+		for(uint16_t i=0; i<contour.num_points; i++){
+			GPoint p = points[i];
+			uint32_t dx = abs(p.x - prev.x);
+			uint32_t dy = abs(p.y - prev.y);
+			perimeter += 2 * (dx > dy ? dx : dy);
+			if(p.x < min_x) min_x = p.x;
+			if(p.x > max_x) max_x = p.x;
+			if(p.y < min_y) min_y = p.y;
+			if(p.y > max_y) max_y = p.y;
+			prev = p;
+		}
+
+		if(contour.flags & AAV_FLAG_STROKE)
+			cost += perimeter * (contour.stroke_width > 1 ? contour.stroke_width : 1);
+		if(contour.flags & AAV_FLAG_FILL)
+			cost += perimeter + (max_x - min_x + 1) * (max_y - min_y + 1);
 	}
-	graphics_release_frame_buffer(ctx, bitmap);
+	return cost;
+}
+
+// Rough number of pixels touched by a primitive, used to split the job in bounded steps
+static uint32_t primitive_cost_(const AAPrimitive* primitive){
+	switch(primitive->type){
+		case AAPrimitiveTypeLine: {
+			uint32_t dx = abs(primitive->line.p1.x - primitive->line.p0.x);
+			uint32_t dy = abs(primitive->line.p1.y - primitive->line.p0.y);
+			return 2 * (dx > dy ? dx : dy) + 1;
+		}
+		case AAPrimitiveTypeCircle:
+			return 13 * primitive->circle.radius + 1;
+		case AAPrimitiveTypeFilledCircle:
+			return (13 + 4 * primitive->circle.radius) * primitive->circle.radius + 1;
+		case AAPrimitiveTypePathOutline:
+		case AAPrimitiveTypePathFilled: {
+			GPath* path = primitive->path;
+			if(path->num_points == 0)
+				return 1;
+			// Rotation doesn't change the perimeter, and barely the area for our needs
+			uint32_t perimeter = 0;
+			int16_t min_x = path->points[0].x, max_x = min_x;
+			int16_t min_y = path->points[0].y, max_y = min_y;
+			GPoint prev = path->points[path->num_points - 1];
+			for(uint32_t i=0; i<path->num_points; i++){
+				GPoint p = path->points[i];
+				uint32_t dx = abs(p.x - prev.x);
+				uint32_t dy = abs(p.y - prev.y);
+				perimeter += 2 * (dx > dy ? dx : dy);
+				if(p.x < min_x) min_x = p.x;
+				if(p.x > max_x) max_x = p.x;
+				if(p.y < min_y) min_y = p.y;
+				if(p.y > max_y) max_y = p.y;
+				prev = p;
+			}
+			if(primitive->type == AAPrimitiveTypePathOutline)
+				return perimeter + 1;
+			return perimeter + (max_x - min_x + 1) * (max_y - min_y + 1);
+		}
+		case AAPrimitiveTypeVector:
+			return aav_cost_(primitive->vector.data, primitive->vector.size);
+	}
+	return 1;
+}
+
+static void primitive_draw_(GBitmap* bitmap, const AAPrimitive* primitive){
+	switch(primitive->type){
+		case AAPrimitiveTypeLine:
+			draw_line_antialias_(bitmap, primitive->line.p0.x, primitive->line.p0.y, primitive->line.p1.x, primitive->line.p1.y, primitive->color);
+			break;
+		case AAPrimitiveTypeCircle:
+			draw_circle_(bitmap, primitive->circle.center, primitive->circle.radius, primitive->color);
+			break;
+		case AAPrimitiveTypeFilledCircle:
+			fill_circle_(bitmap, primitive->circle.center, primitive->circle.radius, primitive->color);
+			break;
+		case AAPrimitiveTypePathOutline:
+			draw_path_outline_(bitmap, primitive->path, primitive->color);
+			break;
+		case AAPrimitiveTypePathFilled:
+			draw_path_filled_(bitmap, primitive->path, primitive->color);
+			break;
+		case AAPrimitiveTypeVector:
+			aav_draw_data_(bitmap, primitive->vector.data, primitive->vector.size, primitive->vector.offset);
+			break;
+	}
+}
+
+AARenderJob* aa_render_job_create(GBitmap* bitmap, const AAPrimitive* primitives, uint16_t num_primitives){
+	AARenderJob* job = malloc(sizeof(AARenderJob));
+	if(!job)
+		return NULL;
+	memset(job, 0, sizeof(AARenderJob));
+
+	job->primitives = malloc(sizeof(AAPrimitive) * num_primitives);
+	if(num_primitives > 0 && !job->primitives){
+		free(job);
+		return NULL;
+	}
+	memcpy(job->primitives, primitives, sizeof(AAPrimitive) * num_primitives);
+	job->num_primitives = num_primitives;
+	job->bitmap = bitmap;
+	return job;
+}
+
+void aa_render_job_destroy(AARenderJob* job){
+	if(!job)
+		return;
+	if(job->timer)
+		app_timer_cancel(job->timer);
+	free(job->primitives);
+	free(job);
+}
+
+bool aa_render_job_is_completed(const AARenderJob* job){
+	return job->next >= job->num_primitives;
+}
+
+bool aa_render_job_step(AARenderJob* job, uint32_t max_primitives, uint32_t max_pixels){
+	uint32_t primitives = 0;
+	uint32_t pixels = 0;
+
+	while(!aa_render_job_is_completed(job)){
+		const AAPrimitive* primitive = &job->primitives[job->next];
+		uint32_t cost = primitive_cost_(primitive);
+
+		// Always move forward by at least one primitive
+		if(primitives > 0 && max_pixels > 0 && pixels + cost > max_pixels)
+			break;
+
+		primitive_draw_(job->bitmap, primitive);
+		job->next++;
+		primitives++;
+		pixels += cost;
+
+		if(max_primitives > 0 && primitives >= max_primitives)
+			break;
+	}
+
+	return aa_render_job_is_completed(job);
+}
+
+static void render_job_timer_callback_(void* data){
+	AARenderJob* job = data;
+	job->timer = NULL;
+
+	if(aa_render_job_step(job, job->max_primitives, job->max_pixels)){
+		if(job->completed_handler)
+			job->completed_handler(job, job->bitmap, job->context);
+	}
+	else {
+		job->timer = app_timer_register(job->interval_ms, render_job_timer_callback_, job);
+	}
+}
+
+void aa_render_job_schedule(AARenderJob* job, uint32_t interval_ms, uint32_t max_primitives, uint32_t max_pixels, 
+	AARenderJobCompletedHandler completed_handler, void* context){
+	if(job->timer)
+		app_timer_cancel(job->timer);
+
+	job->interval_ms 		= interval_ms;
+	job->max_primitives 	= max_primitives;
+	job->max_pixels 		= max_pixels;
+	job->completed_handler 	= completed_handler;
+	job->context 			= context;
+	job->timer 				= app_timer_register(interval_ms, render_job_timer_callback_, job);
 }
 
 /**
-  * From https://github.com/Jnmattern/Minimalist_2.0/blob/master/src/bitmap.h
-  */
-static void bmpFillCircle(GBitmap *bmp, GPoint center, int r, GColor8 c) {
-	int x = 0, y = r, d = r-1, v;
+ * Retained display list
+ * The commands of a frame are recorded with the bounds of the pixels they touch. When the
+ * frame is rendered they are compared with the commands of the previous frame and only the
+ * regions of the commands added, removed or changed are restored from the background and
+ * rasterized again, the rest of the previous frame is kept as is.
+ */
+#define DISPLAY_LIST_MAX_DIRTY 4
+
+typedef struct {
+	AAPrimitive primitive;
+	GRect bounds;         // pixels touched by the primitive
+	int32_t rotation;     // rotation and offset of the path when recorded
+	GPoint offset;
+} AACommand;
+
+struct AADisplayList {
+	GBitmap* 	frame;
+	GBitmap* 	background;
+	GColor8 	background_color;
+	AACommand* 	commands;
+	AACommand* 	previous;
+	uint16_t 	num_commands;
+	uint16_t 	num_previous;
+	uint16_t 	max_commands;
+	bool 		invalid;
+};
+
+static GRect rect_from_extents_(int16_t min_x, int16_t min_y, int16_t max_x, int16_t max_y, int16_t margin){
+	return GRect(min_x - margin, min_y - margin, max_x - min_x + 1 + 2 * margin, max_y - min_y + 1 + 2 * margin);
+}
 
-	uint8_t* img_pixels = gbitmap_get_data(bmp);
-	int16_t  w 	= gbitmap_get_bounds(bmp).size.w;
-    
-	while (y >= x) {
-        for (v=center.x-x; v<=center.x+x; v++) img_pixels[v + w*(center.y+y)] = c.argb;
-        for (v=center.x-y; v<=center.x+y; v++) img_pixels[v + w*(center.y+x)] = c.argb;
-        for (v=center.x-x; v<=center.x+x; v++) img_pixels[v + w*(center.y-y)] = c.argb;
-        for (v=center.x-y; v<=center.x+y; v++) img_pixels[v + w*(center.y-x)] = c.argb;
-        
-		if (d >= 2*x-2) {
-			d = d-2*x;
-			x++;
-		} else if (d <= 2*r - 2*y) {
-			d = d+2*y-1;
-			y--;
-		} else {
-			d = d + 2*y - 2*x - 2;
-			y--;
-			x++;
+static bool rect_is_empty_(const GRect* rect){
+	return rect->size.w <= 0 || rect->size.h <= 0;
+}
+
+static bool rects_intersect_(const GRect* a, const GRect* b){
+	return a->origin.x < b->origin.x + b->size.w && b->origin.x < a->origin.x + a->size.w
+		&& a->origin.y < b->origin.y + b->size.h && b->origin.y < a->origin.y + a->size.h;
+}
+
+static GRect rects_union_(const GRect* a, const GRect* b){
+	int16_t x0 = a->origin.x < b->origin.x ? a->origin.x : b->origin.x;
+	int16_t y0 = a->origin.y < b->origin.y ? a->origin.y : b->origin.y;
+	int16_t x1 = a->origin.x + a->size.w > b->origin.x + b->size.w ? a->origin.x + a->size.w : b->origin.x + b->size.w;
+	int16_t y1 = a->origin.y + a->size.h > b->origin.y + b->size.h ? a->origin.y + a->size.h : b->origin.y + b->size.h;
+	return GRect(x0, y0, x1 - x0, y1 - y0);
+}
+
+static GRect aav_bounds_(const uint8_t* data, size_t size, GPoint offset){
+	uint16_t num_contours;
+	if(size < AAV_HEADER_SIZE || !aav_read_header_(data, &num_contours))
+		return GRectZero;
+
+	// Quadratic curves stay inside their control points
+	int16_t min_x = INT16_MAX, min_y = INT16_MAX, max_x = INT16_MIN, max_y = INT16_MIN;
+	uint8_t max_width = 1;
+	size_t pos = AAV_HEADER_SIZE;
+	for(uint16_t c=0; c<num_contours && pos + AAV_CONTOUR_SIZE <= size; c++){
+		AAVContour contour;
+		aav_read_contour_(data + pos, &contour);
+		pos += AAV_CONTOUR_SIZE;
+
+		size_t body_size = aav_tags_size_(&contour) + contour.num_points * AAV_POINT_SIZE;
+		if(pos + body_size > size)
+			break;
+		const GPoint* points = (const GPoint*)(data + pos + aav_tags_size_(&contour));
+		for(uint16_t i=0; i<contour.num_points; i++){
+			if(points[i].x < min_x) min_x = points[i].x;
+			if(points[i].x > max_x) max_x = points[i].x;
+			if(points[i].y < min_y) min_y = points[i].y;
+			if(points[i].y > max_y) max_y = points[i].y;
 		}
+		if((contour.flags & AAV_FLAG_STROKE) && contour.stroke_width > max_width)
+			max_width = contour.stroke_width;
+		pos += body_size;
 	}
+	if(min_x > max_x)
+		return GRectZero;
+
+	// Mitered joins go up to 4 times the half width
+	return rect_from_extents_(min_x + offset.x, min_y + offset.y, max_x + offset.x, max_y + offset.y, 2 * max_width + 2);
 }
 
-void graphics_fill_circle_antialiased(GContext* ctx, GPoint center, uint16_t radius, GColor8 fill_color){
-	GBitmap* bitmap = graphics_capture_frame_buffer(ctx);
-	bmpFillCircle(bitmap, center, radius-1, fill_color);
-	graphics_release_frame_buffer(ctx, bitmap);
-	graphics_draw_circle_antialiased(ctx, center, radius, fill_color);
+static GRect primitive_bounds_(const AAPrimitive* primitive){
+	switch(primitive->type){
+		case AAPrimitiveTypeLine: {
+			GPoint p0 = primitive->line.p0;
+			GPoint p1 = primitive->line.p1;
+			return rect_from_extents_(p0.x < p1.x ? p0.x : p1.x, p0.y < p1.y ? p0.y : p1.y, 
+				p0.x > p1.x ? p0.x : p1.x, p0.y > p1.y ? p0.y : p1.y, 2);
+		}
+		case AAPrimitiveTypeCircle:
+		case AAPrimitiveTypeFilledCircle: {
+			GPoint c = primitive->circle.center;
+			int16_t r = primitive->circle.radius;
+			return rect_from_extents_(c.x - r, c.y - r, c.x + r, c.y + r, 2);
+		}
+		case AAPrimitiveTypePathOutline:
+		case AAPrimitiveTypePathFilled: {
+			GPath* path = primitive->path;
+			if(path->num_points == 0)
+				return GRectZero;
+			int32_t s = sin_lookup(path->rotation);
+			int32_t c = cos_lookup(path->rotation);
+			int16_t min_x = INT16_MAX, min_y = INT16_MAX, max_x = INT16_MIN, max_y = INT16_MIN;
+			for(uint32_t i=0; i<path->num_points; i++){
+				int16_t x = (path->points[i].x * c - path->points[i].y * s) / TRIG_MAX_RATIO + path->offset.x;
+				int16_t y = (path->points[i].x * s + path->points[i].y * c) / TRIG_MAX_RATIO + path->offset.y;
+				if(x < min_x) min_x = x;
+				if(x > max_x) max_x = x;
+				if(y < min_y) min_y = y;
+				if(y > max_y) max_y = y;
+			}
+			return rect_from_extents_(min_x, min_y, max_x, max_y, 2);
+		}
+		case AAPrimitiveTypeVector:
+			return aav_bounds_(primitive->vector.data, primitive->vector.size, primitive->vector.offset);
+	}
+	return GRectZero;
+}
+
+// Adds a region to redraw. It is merged with the regions it overlaps, again as long as the
+// union overlaps other regions, so the regions never overlap and no pixel is drawn twice.
+// When all the regions are used it is merged with the one growing the least.
+static void dirty_add_(GRect* dirty, uint8_t* num_dirty, GRect rect){
+	if(rect_is_empty_(&rect))
+		return;
+
+	bool merged = true;
+	while(merged){
+		merged = false;
+		for(uint8_t i=0; i<*num_dirty; i++){
+			if(rects_intersect_(&dirty[i], &rect)){
+				// The union replaces this region and is checked again
+				rect = rects_union_(&dirty[i], &rect);
+				dirty[i] = dirty[--(*num_dirty)];
+				merged = true;
+				break;
+			}
+		}
+	}
+	if(*num_dirty < DISPLAY_LIST_MAX_DIRTY){
+		dirty[(*num_dirty)++] = rect;
+		return;
+	}
+
+	uint8_t best = 0;
+	int32_t best_growth = INT32_MAX;
+	for(uint8_t i=0; i<*num_dirty; i++){
+		GRect grown = rects_union_(&dirty[i], &rect);
+		int32_t growth = grown.size.w * grown.size.h - dirty[i].size.w * dirty[i].size.h;
+		if(growth < best_growth){
+			best = i;
+			best_growth = growth;
+		}
+	}
+	rect = rects_union_(&dirty[best], &rect);
+	dirty[best] = dirty[--(*num_dirty)];
+	dirty_add_(dirty, num_dirty, rect);
+}
+
+static void display_list_restore_background_(AADisplayList* list, GRect rect){
+	uint8_t* pixels = gbitmap_get_data(list->frame);
+	uint16_t stride = gbitmap_get_bytes_per_row(list->frame);
+
+	if(list->background){
+		uint8_t* background = gbitmap_get_data(list->background);
+		uint16_t background_stride = gbitmap_get_bytes_per_row(list->background);
+		for(int16_t y=rect.origin.y; y<rect.origin.y + rect.size.h; y++)
+			memcpy(pixels + rect.origin.x + stride * y, background + rect.origin.x + background_stride * y, rect.size.w);
+	}
+	else {
+		for(int16_t y=rect.origin.y; y<rect.origin.y + rect.size.h; y++)
+			memset(pixels + rect.origin.x + stride * y, list->background_color.argb, rect.size.w);
+	}
+}
+
+AADisplayList* aa_display_list_create(GSize size, GColor8 background_color){
+	AADisplayList* list = malloc(sizeof(AADisplayList));
+	if(!list)
+		return NULL;
+	memset(list, 0, sizeof(AADisplayList));
+
+	list->frame = gbitmap_create_blank(size, GBitmapFormat8Bit);
+	if(!list->frame){
+		free(list);
+		return NULL;
+	}
+	list->background_color = background_color;
+	list->invalid = true;
+	return list;
+}
+
+void aa_display_list_destroy(AADisplayList* list){
+	if(!list)
+		return;
+	gbitmap_destroy(list->frame);
+	free(list->commands);
+	free(list->previous);
+	free(list);
+}
+
+void aa_display_list_set_background(AADisplayList* list, GBitmap* background){
+	list->background = background;
+	list->invalid = true;
+}
+
+void aa_display_list_invalidate(AADisplayList* list){
+	list->invalid = true;
+}
+
+void aa_display_list_begin(AADisplayList* list){
+	list->num_commands = 0;
+}
+
+bool aa_display_list_add(AADisplayList* list, const AAPrimitive* primitive){
+	if(list->num_commands == list->max_commands){
+		uint16_t max_commands = list->max_commands * 2 + 8;
+		AACommand* commands = realloc(list->commands, sizeof(AACommand) * max_commands);
+		if(!commands)
+			return false;
+		list->commands = commands;
+		AACommand* previous = realloc(list->previous, sizeof(AACommand) * max_commands);
+		if(!previous)
+			return false;
+		list->previous = previous;
+		list->max_commands = max_commands;
+	}
+
+	// Commands are compared byte per byte, only copy what the primitive uses
+	AACommand* command = &list->commands[list->num_commands++];
+	memset(command, 0, sizeof(AACommand));
+	command->primitive.type = primitive->type;
+	command->primitive.color = primitive->color;
+	switch(primitive->type){
+		case AAPrimitiveTypeLine:
+			command->primitive.line.p0 = primitive->line.p0;
+			command->primitive.line.p1 = primitive->line.p1;
+			break;
+		case AAPrimitiveTypeCircle:
+		case AAPrimitiveTypeFilledCircle:
+			command->primitive.circle.center = primitive->circle.center;
+			command->primitive.circle.radius = primitive->circle.radius;
+			break;
+		case AAPrimitiveTypePathOutline:
+		case AAPrimitiveTypePathFilled:
+			command->primitive.path = primitive->path;
+			command->rotation = primitive->path->rotation;
+			command->offset = primitive->path->offset;
+			break;
+		case AAPrimitiveTypeVector:
+			command->primitive.vector.data = primitive->vector.data;
+			command->primitive.vector.size = primitive->vector.size;
+			command->primitive.vector.offset = primitive->vector.offset;
+			break;
+	}
+	command->bounds = primitive_bounds_(&command->primitive);
+	return true;
+}
+
+void aa_display_list_render(AADisplayList* list, GContext* ctx){
+	GRect frame_bounds = gbitmap_get_bounds(list->frame);
+
+	// Regions of the commands added, removed or changed since the previous frame
+	GRect dirty[DISPLAY_LIST_MAX_DIRTY];
+	uint8_t num_dirty = 0;
+	if(list->invalid){
+		dirty[num_dirty++] = frame_bounds;
+	}
+	else {
+		uint16_t count = list->num_commands > list->num_previous ? list->num_commands : list->num_previous;
+		for(uint16_t i=0; i<count; i++){
+			bool added = i >= list->num_previous;
+			bool removed = i >= list->num_commands;
+			if(!added && !removed && memcmp(&list->commands[i], &list->previous[i], sizeof(AACommand)) == 0)
+				continue;
+			if(!added)
+				dirty_add_(dirty, &num_dirty, list->previous[i].bounds);
+			if(!removed)
+				dirty_add_(dirty, &num_dirty, list->commands[i].bounds);
+		}
+	}
+
+	bool failed = false;
+	for(uint8_t d=0; d<num_dirty; d++){
+		grect_clip(&dirty[d], &frame_bounds);
+		if(rect_is_empty_(&dirty[d]))
+			continue;
+
+		display_list_restore_background_(list, dirty[d]);
+
+		// Every command touching the region is drawn again, clipped to the region
+		GBitmap* region = gbitmap_create_as_sub_bitmap(list->frame, dirty[d]);
+		if(!region){
+			failed = true;
+			continue;
+		}
+		for(uint16_t i=0; i<list->num_commands; i++){
+			if(rects_intersect_(&list->commands[i].bounds, &dirty[d]))
+				primitive_draw_(region, &list->commands[i].primitive);
+		}
+		gbitmap_destroy(region);
+	}
+
+	// The frame buffer is not kept between two frames, the layer is drawn again under the list,
+	// so the whole frame is copied : only the dirty regions are rasterized again
+	graphics_draw_bitmap_in_rect(ctx, list->frame, frame_bounds);
+
+	// The recorded frame becomes the reference of the next one
+	AACommand* commands = list->previous;
+	list->previous = list->commands;
+	list->commands = commands;
+	list->num_previous = list->num_commands;
+	list->num_commands = 0;
+	list->invalid = failed;
 }
 
 #undef swap_
+#undef dial_row_
+#undef aav_read_u16_
+#undef aav_tags_size_
 #undef ipart_
 #undef fpart_
 #undef rfpart_
 #undef interpol_color_
-#undef set_pixel_
-#undef get_pixel
+#undef interpol_color_pair_
 
 #endif  // PBL_COLOR
 
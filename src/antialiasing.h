@@ -44,6 +44,215 @@ void gpath_draw_filled_antialiased(GContext* ctx, GPath *path, GColor8 fill_colo
 //! @see \ref graphics_context_set_stroke_color()
 void gpath_draw_outline_antialiased(GContext* ctx, GPath *path, GColor8 stroke_color);
 
+//! Fills a path and draws its outline with antialiasing in a single pass, the path is transformed
+//! only once and the interior, the edge between the fill and the outline and the outline itself
+//! are composed row by row.
+//! @param ctx The graphics context to draw into
+//! @param path The path to draw
+//! @param fill_color The fill color, GColorClear to only draw the outline
+//! @param stroke_color The outline color, GColorClear to only draw the fill
+//! @param stroke_width The width of the outline in pixels, centered on the path, 0 for no outline
+void gpath_draw_antialiased(GContext* ctx, GPath *path, GColor8 fill_color, GColor8 stroke_color, uint8_t stroke_width);
+
+//! Shape of the ends of an open thick stroke
+typedef enum {
+  AALineCapButt,    //!< The stroke stops at the end points
+  AALineCapRound,   //!< A half circle around the end points
+  AALineCapSquare,  //!< The stroke goes half its width past the end points
+} AALineCap;
+
+//! Shape of the corners of a thick stroke
+typedef enum {
+  AALineJoinMiter,  //!< Sharp corners, beveled when longer than 4 times the half width
+  AALineJoinRound,  //!< Rounded corners
+} AALineJoin;
+
+// //! Draws a line of any width with antialiasing, the interior is drawn once and only its edges are blended
+// //! @param ctx The destination graphics context in which to draw
+// //! @param p0 The starting point of the line
+// //! @param p1 The ending point of the line
+// //! @param stroke_width The width of the line in pixels
+// //! @param cap The shape of both ends of the line
+// //! @param stroke_color The stroke color
+void graphics_draw_thick_line_antialiased(GContext* ctx, GPoint p0, GPoint p1, uint8_t stroke_width, AALineCap cap, GColor8 stroke_color);
+
+// //! Draws the outline of a path with any width with antialiasing
+// //! @param ctx The graphics context to draw into
+// //! @param path The path to draw
+// //! @param stroke_width The width of the outline in pixels, centered on the path
+// //! @param join The shape of the corners
+// //! @param stroke_color The stroke color
+void gpath_draw_thick_outline_antialiased(GContext* ctx, GPath *path, uint8_t stroke_width, AALineJoin join, GColor8 stroke_color);
+
+// //! Draws the outline of a path with any width with antialiasing, without joining the last point to the first one
+// //! @param ctx The graphics context to draw into
+// //! @param path The path to draw
+// //! @param stroke_width The width of the outline in pixels, centered on the path
+// //! @param cap The shape of both ends of the outline
+// //! @param join The shape of the corners
+// //! @param stroke_color The stroke color
+void gpath_draw_thick_outline_open_antialiased(GContext* ctx, GPath *path, uint8_t stroke_width, AALineCap cap, AALineJoin join, GColor8 stroke_color);
+
+// //! Draws the outline of a circle with any width with antialiasing
+// //! @param ctx The destination graphics context in which to draw
+// //! @param center The center point of the circle
+// //! @param radius The radius in pixels
+// //! @param stroke_width The width of the outline in pixels, centered on the radius
+// //! @param stroke_color The stroke color
+void graphics_draw_thick_circle_antialiased(GContext* ctx, GPoint center, uint16_t radius, uint8_t stroke_width, GColor8 stroke_color);
+
+// //! Draws count radial tick marks evenly spaced around a center with antialiasing, the first one
+// //! pointing to the right. When count is a multiple of 4 only one eighth of the dial is rasterized.
+// //! @param ctx The destination graphics context in which to draw
+// //! @param center The center point of the dial
+// //! @param inner_radius The distance from the center to the inner end of the ticks
+// //! @param outer_radius The distance from the center to the outer end of the ticks
+// //! @param count The number of ticks, e.g. 12 or 60
+// //! @param width The width of the ticks in pixels
+// //! @param color The color of the ticks
+void graphics_draw_dial_antialiased(GContext* ctx, GPoint center, uint16_t inner_radius, uint16_t outer_radius, 
+  uint16_t count, uint8_t width, GColor8 color);
+
+//! Dial geometry rasterized once and drawn any number of times
+typedef struct AADial AADial;
+
+// //! Creates a dial, see graphics_draw_dial_antialiased(). When count is a multiple of 4 the coverage
+// //! of one eighth of the dial is computed here and kept, about (outer_radius + width)^2 / 2 bytes.
+// //! @return The dial, or NULL if there is not enough memory
+AADial* aa_dial_create(uint16_t inner_radius, uint16_t outer_radius, uint16_t count, uint8_t width);
+
+// //! Destroys a dial
+void aa_dial_destroy(AADial* dial);
+
+// //! Draws a dial by mirroring its cached coverage, without rasterizing it again
+// //! @param ctx The destination graphics context in which to draw
+// //! @param dial The dial
+// //! @param center The center point of the dial
+// //! @param color The color of the ticks
+void aa_dial_draw(GContext* ctx, const AADial* dial, GPoint center, GColor8 color);
+
+// //! Draws a vector image stored in the compact AAV format (see tools/aav_convert.py)
+// //! straight from its data, without creating any GPath.
+// //! @param ctx The destination graphics context in which to draw
+// //! @param data The AAV data, typically loaded once with resource_load()
+// //! @param size The size of the data in bytes
+// //! @param offset The offset added to every point of the image
+void gvector_draw_antialiased(GContext* ctx, const uint8_t* data, size_t size, GPoint offset);
+
+// //! Draws a vector image stored in the compact AAV format by streaming it from a resource,
+// //! only one contour at a time is loaded in memory.
+// //! @param ctx The destination graphics context in which to draw
+// //! @param resource_id The id of the raw resource holding the AAV data
+// //! @param offset The offset added to every point of the image
+void gvector_draw_resource_antialiased(GContext* ctx, uint32_t resource_id, GPoint offset);
+
+typedef enum {
+  AAPrimitiveTypeLine,          //!< uses line, drawn like graphics_draw_line_antialiased()
+  AAPrimitiveTypeCircle,        //!< uses circle, drawn like graphics_draw_circle_antialiased()
+  AAPrimitiveTypeFilledCircle,  //!< uses circle, drawn like graphics_fill_circle_antialiased()
+  AAPrimitiveTypePathOutline,   //!< uses path, drawn like gpath_draw_outline_antialiased()
+  AAPrimitiveTypePathFilled,    //!< uses path, drawn like gpath_draw_filled_antialiased()
+  AAPrimitiveTypeVector,        //!< uses vector, drawn like gvector_draw_antialiased()
+} AAPrimitiveType;
+
+//! One drawing operation of a render job
+typedef struct {
+  AAPrimitiveType type;
+  GColor8 color;
+  union {
+    struct {
+      GPoint p0;
+      GPoint p1;
+    } line;
+    struct {
+      GPoint center;
+      uint16_t radius;
+    } circle;
+    GPath* path;
+    struct {
+      const uint8_t* data;
+      size_t size;
+      GPoint offset;
+    } vector;
+  };
+} AAPrimitive;
+
+//! Resumable rendering of a list of primitives into an offscreen bitmap
+typedef struct AARenderJob AARenderJob;
+
+//! Called once every primitive of the job has been rendered
+typedef void (*AARenderJobCompletedHandler)(AARenderJob* job, GBitmap* bitmap, void* context);
+
+// //! Creates a render job drawing the given primitives, in order, into an 8 bit bitmap.
+// //! The primitives are copied but the paths, vector data and bitmap must stay valid until the job is destroyed.
+// //! @param bitmap The GBitmapFormat8Bit bitmap to draw into, see gbitmap_create_blank()
+// //! @param primitives The primitives to draw
+// //! @param num_primitives The number of primitives
+// //! @return The job, or NULL if there is not enough memory
+AARenderJob* aa_render_job_create(GBitmap* bitmap, const AAPrimitive* primitives, uint16_t num_primitives);
+
+// //! Destroys a render job and cancels its pending step if any. The bitmap is not destroyed.
+void aa_render_job_destroy(AARenderJob* job);
+
+// //! Renders the next primitives of the job. At least one primitive is rendered per step.
+// //! @param job The render job
+// //! @param max_primitives The maximum number of primitives to render, 0 for no limit
+// //! @param max_pixels The approximate maximum number of pixels to touch, 0 for no limit
+// //! @return true if the job is completed
+bool aa_render_job_step(AARenderJob* job, uint32_t max_primitives, uint32_t max_pixels);
+
+// //! Renders the job in the background, one step every interval_ms from an app_timer,
+// //! so that the event loop keeps handling input between the steps.
+// //! @param job The render job
+// //! @param interval_ms The delay between two steps
+// //! @param max_primitives The maximum number of primitives per step, 0 for no limit
+// //! @param max_pixels The approximate maximum number of pixels per step, 0 for no limit
+// //! @param completed_handler Called when the job is completed, can be NULL
+// //! @param context Passed to completed_handler
+void aa_render_job_schedule(AARenderJob* job, uint32_t interval_ms, uint32_t max_primitives, uint32_t max_pixels, 
+  AARenderJobCompletedHandler completed_handler, void* context);
+
+// //! @return true once every primitive of the job has been rendered
+bool aa_render_job_is_completed(const AARenderJob* job);
+
+//! Retained list of primitives redrawing only what changed since the previous frame
+typedef struct AADisplayList AADisplayList;
+
+// //! Creates a display list rendering frames of the given size over a cached background.
+// //! The list keeps the last frame in an 8 bit bitmap of that size.
+// //! @param size The size of the frames, usually the size of the layer
+// //! @param background_color The background color, used when no background bitmap is set
+// //! @return The display list, or NULL if there is not enough memory
+AADisplayList* aa_display_list_create(GSize size, GColor8 background_color);
+
+// //! Destroys a display list. The background bitmap is not destroyed.
+void aa_display_list_destroy(AADisplayList* list);
+
+// //! Sets the 8 bit bitmap, of the size of the frames, drawn behind the primitives, for instance 
+// //! rendered once with a render job. The next frame is fully redrawn.
+// //! @param list The display list
+// //! @param background The background bitmap, NULL to use the background color
+void aa_display_list_set_background(AADisplayList* list, GBitmap* background);
+
+// //! Fully redraws the next frame, for instance after changing the content of the background bitmap
+void aa_display_list_invalidate(AADisplayList* list);
+
+// //! Starts recording the primitives of a new frame
+void aa_display_list_begin(AADisplayList* list);
+
+// //! Records a primitive of the frame. Primitives are compared with the ones recorded at the same
+// //! position in the previous frame, the points of a path are not compared, only its rotation and offset.
+// //! @param list The display list
+// //! @param primitive The primitive, copied in the list
+// //! @return false if there is not enough memory
+bool aa_display_list_add(AADisplayList* list, const AAPrimitive* primitive);
+
+// //! Rasterizes again only the regions of the primitives added, removed or changed since the
+// //! previous frame and draws the frame into the graphics context.
+// //! @param list The display list
+// //! @param ctx The graphics context to draw into
+void aa_display_list_render(AADisplayList* list, GContext* ctx);
+
 #else  //PBL_COLOR
 
 #define gpath_draw_outline_antialiased gpath_draw_outline
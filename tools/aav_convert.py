@@ -0,0 +1,242 @@
+#!/usr/bin/env python
+#
+# aav_convert.py by Grégoire Sage
+# https://github.com/gregoiresage/pebble-antialiasing-lib
+#
+# Converts vector art into the compact AAV format drawn by gvector_draw_antialiased()
+# and gvector_draw_resource_antialiased().
+#
+# Input is either a JSON description :
+#
+#   { "contours": [
+#       { "points": [[-10, 0], [0, -10, "control"], [10, 0]],
+#         "fill": "#FFAA00", "stroke": "#000000", "stroke_width": 1, "closed": true },
+#       { "points": [[-2, -2], [2, -2], [2, -1]], "continues": true } ] }
+#
+# A contour which "continues" the previous one is filled with it in one pass, with the fill of
+# the first contour : holes wound the other way are left empty (non-zero fill rule).
+#
+# or a SVG file using <polygon>, <polyline> and <path> elements (M, L, H, V, Q, T and Z
+# commands, absolute or relative) with their fill, stroke and stroke-width attributes.
+# The sub-paths of a <path> continue its first one, so they can cut holes in it.
+#
+# Usage : aav_convert.py input.(json|svg) output.aav [--scale S] [--origin X Y]
+#
+# Add the output to appinfo.json as a "raw" media resource.
+
+import argparse
+import json
+import re
+import struct
+import sys
+import xml.etree.ElementTree as ET
+
+AAV_VERSION = 1
+
+AAV_FLAG_FILL = 0x01
+AAV_FLAG_STROKE = 0x02
+AAV_FLAG_CLOSED = 0x04
+AAV_FLAG_CURVES = 0x08
+AAV_FLAG_CONTINUE = 0x10
+
+AAV_TAG_ON_CURVE = 0x00
+AAV_TAG_CONTROL = 0x01
+
+SVG_COLORS = {
+    'black': '#000000', 'white': '#ffffff', 'red': '#ff0000', 'green': '#00ff00',
+    'blue': '#0000ff', 'yellow': '#ffff00', 'cyan': '#00ffff', 'magenta': '#ff00ff',
+}
+
+
+def color_to_argb8(color):
+    """Converts a #RGB or #RRGGBB color into a GColor8 argb value"""
+    color = SVG_COLORS.get(color.lower(), color).lstrip('#')
+    if len(color) == 3:
+        color = ''.join(c * 2 for c in color)
+    if len(color) != 6:
+        raise ValueError('unsupported color "%s"' % color)
+    r, g, b = (int(color[i:i + 2], 16) for i in (0, 2, 4))
+    return 0xC0 | ((r >> 6) << 4) | ((g >> 6) << 2) | (b >> 6)
+
+
+def encode_contour(contour):
+    points = contour['points']
+    if len(points) == 0 or len(points) > 0xFFFF:
+        raise ValueError('a contour needs between 1 and 65535 points')
+
+    flags = 0
+    fill = contour.get('fill')
+    stroke = contour.get('stroke')
+    if fill:
+        flags |= AAV_FLAG_FILL
+    if stroke:
+        flags |= AAV_FLAG_STROKE
+    if contour.get('closed', bool(fill)):
+        flags |= AAV_FLAG_CLOSED
+    if contour.get('continues'):
+        flags |= AAV_FLAG_CONTINUE
+
+    tags = [AAV_TAG_CONTROL if len(p) > 2 and p[2] == 'control' else AAV_TAG_ON_CURVE for p in points]
+    if AAV_TAG_CONTROL in tags:
+        flags |= AAV_FLAG_CURVES
+        if AAV_TAG_ON_CURVE not in tags:
+            raise ValueError('a curved contour needs at least one on-curve point')
+        if not flags & AAV_FLAG_CLOSED and (tags[0] != AAV_TAG_ON_CURVE or tags[-1] != AAV_TAG_ON_CURVE):
+            raise ValueError('an open contour must start and end on-curve')
+
+    data = struct.pack('<BBBBH', flags,
+                       color_to_argb8(fill) if fill else 0,
+                       color_to_argb8(stroke) if stroke else 0,
+                       int(contour.get('stroke_width', 1)),
+                       len(points))
+    if flags & AAV_FLAG_CURVES:
+        data += bytes(bytearray(tags))
+        if len(tags) % 2:
+            data += b'\0'
+    for p in points:
+        data += struct.pack('<hh', int(round(p[0])), int(round(p[1])))
+    return data
+
+
+def encode(contours):
+    if contours and contours[0].get('continues'):
+        raise ValueError('the first contour cannot continue a previous one')
+    data = struct.pack('<BBBBH', ord('A'), ord('V'), AAV_VERSION, 0, len(contours))
+    for contour in contours:
+        data += encode_contour(contour)
+    return data
+
+
+def parse_svg_path(d):
+    """Returns the sub-paths of a SVG path as (points, closed) tuples"""
+    tokens = re.findall(r'[MmLlHhVvQqTtZzCcSsAa]|[-+]?(?:\d+\.?\d*|\.\d+)(?:[eE][-+]?\d+)?', d)
+    subpaths = []
+    points = []
+    x = y = 0.0
+    start = (0.0, 0.0)
+    last_control = None
+    command = None
+    i = 0
+
+    while i < len(tokens):
+        if re.match(r'[A-Za-z]', tokens[i]):
+            command = tokens[i]
+            i += 1
+            if command in 'Zz':
+                if points:
+                    subpaths.append((points, True))
+                points = []
+                x, y = start
+                last_control = None
+                continue
+            if command in 'CcSsAa':
+                raise ValueError('cubic curves and arcs are not supported, use quadratic curves')
+        relative = command.islower()
+        c = command.upper()
+        if c == 'M':
+            if points:
+                subpaths.append((points, False))
+            nx, ny = float(tokens[i]), float(tokens[i + 1])
+            i += 2
+            x, y = (x + nx, y + ny) if relative else (nx, ny)
+            start = (x, y)
+            points = [[x, y]]
+            command = 'l' if relative else 'L'
+            last_control = None
+        elif c == 'L':
+            nx, ny = float(tokens[i]), float(tokens[i + 1])
+            i += 2
+            x, y = (x + nx, y + ny) if relative else (nx, ny)
+            points.append([x, y])
+            last_control = None
+        elif c == 'H':
+            nx = float(tokens[i])
+            i += 1
+            x = x + nx if relative else nx
+            points.append([x, y])
+            last_control = None
+        elif c == 'V':
+            ny = float(tokens[i])
+            i += 1
+            y = y + ny if relative else ny
+            points.append([x, y])
+            last_control = None
+        elif c == 'Q':
+            cx, cy, nx, ny = (float(t) for t in tokens[i:i + 4])
+            i += 4
+            if relative:
+                cx, cy, nx, ny = cx + x, cy + y, nx + x, ny + y
+            points.append([cx, cy, 'control'])
+            x, y = nx, ny
+            points.append([x, y])
+            last_control = (cx, cy)
+        elif c == 'T':
+            nx, ny = float(tokens[i]), float(tokens[i + 1])
+            i += 2
+            if relative:
+                nx, ny = nx + x, ny + y
+            cx, cy = (2 * x - last_control[0], 2 * y - last_control[1]) if last_control else (x, y)
+            points.append([cx, cy, 'control'])
+            x, y = nx, ny
+            points.append([x, y])
+            last_control = (cx, cy)
+    if points:
+        subpaths.append((points, False))
+    return subpaths
+
+
+def parse_svg(path):
+    contours = []
+    for element in ET.parse(path).iter():
+        tag = element.tag.split('}')[-1]
+        style = dict(item.split(':', 1) for item in element.get('style', '').split(';') if ':' in item)
+
+        def attribute(name, default=None):
+            value = style.get(name, element.get(name, default))
+            return None if value in (None, 'none') else value.strip()
+
+        if tag in ('polygon', 'polyline'):
+            values = [float(v) for v in re.split(r'[\s,]+', element.get('points', '').strip()) if v]
+            subpaths = [([[values[j], values[j + 1]] for j in range(0, len(values) - 1, 2)], tag == 'polygon')]
+        elif tag == 'path':
+            subpaths = parse_svg_path(element.get('d', ''))
+        else:
+            continue
+
+        fill = attribute('fill', '#000000')
+        stroke = attribute('stroke')
+        width = attribute('stroke-width', '1')
+        for i, (points, closed) in enumerate(subpaths):
+            contours.append({'points': points, 'fill': fill, 'stroke': stroke,
+                             'stroke_width': max(1, int(round(float(width)))), 'closed': closed or bool(fill),
+                             'continues': i > 0})
+    return contours
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Converts vector art into the AAV format')
+    parser.add_argument('input', help='JSON or SVG file')
+    parser.add_argument('output', help='AAV file to write')
+    parser.add_argument('--scale', type=float, default=1.0, help='scale applied to every point')
+    parser.add_argument('--origin', type=float, nargs=2, default=(0.0, 0.0), metavar=('X', 'Y'),
+                        help='point of the input mapped to (0,0), before scaling')
+    args = parser.parse_args()
+
+    if args.input.lower().endswith('.svg'):
+        contours = parse_svg(args.input)
+    else:
+        with open(args.input) as f:
+            contours = json.load(f)['contours']
+
+    for contour in contours:
+        contour['points'] = [[(p[0] - args.origin[0]) * args.scale, (p[1] - args.origin[1]) * args.scale] + list(p[2:])
+                             for p in contour['points']]
+
+    data = encode(contours)
+    with open(args.output, 'wb') as f:
+        f.write(data)
+    sys.stdout.write('%s : %d contours, %d bytes\n' % (args.output, len(contours), len(data)))
+
+
+if __name__ == '__main__':
+    main()